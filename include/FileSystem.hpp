@@ -59,21 +59,30 @@ canonical(const std::string& path) noexcept
     }
 }
 
-// using FileList =  std::vector<FS::path>;
-//
-// /// Load the content of a shader into a string
-// /// @param file_name The <B>canonical</B> path to the shader.
-// /// @param include_folders A list of folders available to include files from
-// /// @param [out] into The string to hold the file content
-// /// @param [out] dependencies A list of <B>canonical</B> paths to actual file dependencies, including @p file_name.
-// /// @returns True if loaded successfully. Otherwise false.
-// /// @details It recurse but can detect and ignore on cyclic include in shader code. But don't do that anyway!
-// /// @note The include mechanism here is <B>NOT</B> that in ARB_shading_language_include.
-// /// Concretely, here we really do query the filesystem on OS for the files we include,
-// /// while the extension can only "#include" files already uploaded to OpenGL.
-// /// @sa <a href="https://www.khronos.org/registry/OpenGL/extensions/ARB/ARB_shading_language_include.txt">ARB_shading_language_include Registry</a>
-// bool
-// load_shader(const FS::path& file_name, std::string& into, FileList& dependencies);
+using FileList =  std::vector<FS::path>;
+
+/// Split a glob pattern into the directory it's rooted at and the pattern relative to that directory.
+/// @param glob A glob pattern, e.g. "shaders/**/*.frag".
+/// @return The longest leading path without wildcards ("." if none), and the rest of the pattern.
+std::pair<FS::path, FS::path>
+glob_split(const std::string& glob);
+
+/// Match a relative path against a glob pattern.
+/// @param pattern Glob pattern where '*' and '?' match within a path component,
+/// while a component of "**" matches any number of components, including zero.
+/// @param path The path to match, relative to where @p pattern is rooted.
+/// @return True if @p path matches @p pattern.
+bool
+glob_match(const FS::path& pattern, const FS::path& path);
+
+/// Resolve the canonical path of a relative path.
+/// @param base_path The base directory.
+/// @param relative_path The path relative to the @p base_path.
+/// @details When determining the actual base path, @p base_path is considered first of all.
+/// Only if not found under @p base_path will folders in options.includes be tried one by one.
+/// @returns The canonical path if resolved successfully. Otherwise empty path.
+std::string
+resolve_url(const FS::path& base_path, const FS::path& relative_path);
 
 } // namespace FS
 
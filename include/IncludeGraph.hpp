@@ -0,0 +1,61 @@
+/**
+ * @File IncludeGraph.hpp
+ * @author Zhen Luo 461652354@qq.com
+ */
+#pragma once
+
+#include "FileSystem.hpp"
+#include <unordered_map>
+#include <unordered_set>
+
+
+/// Persistent graph of '#include' relations between shader files.
+/// @details Nodes are <B>canonical</B> paths; an edge A->B means A includes B. Reverse edges are kept as well, so
+/// that files affected by a change in a shared file can be found without scanning every program.
+/// Files explicitly imported are roots and always stay in the graph; files merely included are dropped as soon as
+/// no root reaches them anymore, even if they still include each other in a cycle.
+class IncludeGraph {
+  public:
+    using FileSet = std::unordered_set<FS::path>;
+
+    /// Changes of the node set caused by an update.
+    struct Changes {
+        /// Files newly added to the graph.
+        FS::FileList added;
+        /// Files dropped from the graph since no root reaches them anymore.
+        FS::FileList removed;
+    };
+
+    /// @brief Replace the out-going edges of @p file.
+    /// @param file The file whose includes changed.
+    /// @param includes Files directly included by @p file.
+    /// @param root True if @p file is imported explicitly rather than merely included.
+    Changes update(const FS::path& file, const FS::FileList& includes, bool root = false);
+
+    /// @brief Drop the root status of @p file, removing it if no root reaches it.
+    Changes remove_root(const FS::path& file);
+
+    /// @brief Obtain every file that includes @p file directly or indirectly, and @p file itself.
+    FileSet dependents(const FS::path& file) const;
+
+    /// @brief Obtain every file included by @p file directly or indirectly, and @p file itself.
+    FileSet closure(const FS::path& file) const;
+
+    bool contains(const FS::path& file) const
+    { return m_nodes.find(file) != m_nodes.end(); }
+
+  private:
+    struct Node {
+        FS::FileList includes;
+        FileSet included_by;
+        bool root = false;
+    };
+
+    std::unordered_map<FS::path, Node> m_nodes;
+
+    /// Remove @p file and files it includes, directly or indirectly, that no root reaches.
+    void aux_prune(const FS::path& file, Changes& changes);
+
+    template <typename Edges>
+    FileSet aux_traverse(const FS::path& file, Edges edges) const;
+};
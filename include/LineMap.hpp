@@ -0,0 +1,62 @@
+/**
+ * @File LineMap.hpp
+ * @brief Map lines of a preprocessed source back to the files they come from.
+ * @author Zhen Luo 461652354@qq.com
+ */
+#pragma once
+
+#include "FileSystem.hpp"
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+
+/// Interval table from lines of a preprocessed source to lines of original files.
+/// @details Each interval is a run of consecutive lines coming from consecutive lines of one file, so the table only
+/// grows with the number of '#include's and not with the length of the source. Lookups binary search it.
+class LineMap {
+  public:
+    /// Index of a file, usually into PreprocessedSource::files.
+    using FileIndex = std::uint32_t;
+
+    /// File index of lines not coming from any file, such as inserted '#define's.
+    static constexpr FileIndex Generated = std::numeric_limits<FileIndex>::max();
+
+    struct Location {
+        FileIndex file;
+        /// 1-based line number in the file.
+        std::size_t line;
+    };
+
+    /// @brief Start an interval.
+    /// @details Lines from @p expanded on come from consecutive lines of @p file, starting at @p line, until the
+    /// next interval starts.
+    /// @param expanded 1-based line number in the preprocessed source, no less than that of the last interval.
+    void add(std::size_t expanded, FileIndex file, std::size_t line);
+
+    /// Insert @p count generated lines before every other line.
+    void prepend_generated(std::size_t count);
+
+    /// Locate 1-based line @p expanded of the preprocessed source in the original files.
+    Location locate(std::size_t expanded) const;
+
+    /// @brief Rewrite locations in an info log to refer to original files and lines.
+    /// @details Understands locations leading a line of log in the forms of "0(12)" (NVIDIA), "0:12(5)" (Mesa) and
+    /// "ERROR: 0:12:" (AMD), where 0 is the source string number and 12 the line number.
+    /// @param log Info log of compiling the preprocessed source as a single source string.
+    /// @param files Paths of files indexed by file indices used in this map.
+    std::string rewrite(const std::string& log, const FS::FileList& files) const;
+
+    std::size_t size() const
+    { return m_intervals.size(); }
+
+  private:
+    struct Interval {
+        std::uint32_t expanded;
+        FileIndex file;
+        std::uint32_t line;
+    };
+
+    std::vector<Interval> m_intervals;
+};
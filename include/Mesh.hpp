@@ -8,20 +8,47 @@
 #include "OpenGL/VertexLayout.hpp"
 #include "OpenGL/VertexBuffer.hpp"
 #include "OpenGL/Introspection/Introspector.hpp"
+#include "OpenGL/Introspection/InterfaceDiff.hpp"
 
 
 class MeshBase {
   public:
-    MeshBase(std::size_t n_vertices) : m_n_vertices(n_vertices)
+    /// A range of vertices drawn with the same material.
+    struct Part {
+        GLint first;
+        GLsizei count;
+        /// Index of the material among those imported with the mesh, -1 if none.
+        GLint material;
+    };
+
+    MeshBase(std::size_t n_vertices) : m_n_vertices(n_vertices),
+                                       m_parts{{0, static_cast<GLsizei>(n_vertices), -1}}
     {}
 
     void draw(GLuint program)
+    {
+        draw(program, [](GLint) {});
+    }
+
+    /// @brief Draw part by part, calling @p use_material with the material of each part before drawing it.
+    template <typename F>
+    void draw(GLuint program, F&& use_material)
     {
         update_layout(program);
         m_layout.bind();
-        glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(m_n_vertices));
+        for (auto&& part : m_parts) {
+            use_material(part.material);
+            glDrawArrays(GL_TRIANGLES, part.first, part.count);
+        }
     }
 
+    /// @brief Replace parts, which must cover all vertices, e.g. once sorted by material.
+    void parts(std::vector<Part> parts)
+    { m_parts = std::move(parts); }
+
+    const std::vector<Part>& parts() const
+    { return m_parts; }
+
     virtual void upload_all() = 0;
 
     virtual void update_layout(GLuint program) = 0;
@@ -30,12 +57,17 @@ class MeshBase {
     /// Cached name of shader program used in vertex stage to draw this mesh.
     /// @note When expired, m_layout should be updated.
     GLuint m_vertex_program = 0;
+    /// Signature of inputs of m_vertex_program, which m_layout is defined for.
+    /// @note Programs of the same signature, e.g. one reloaded with nothing but its logic edited, share the layout.
+    std::uint64_t m_input_signature = 0;
     /// Contains all the vertex attributes this mesh provides.
     /// @details Any shader demanding less than what we have will work happily,
     /// but those expecting more should complain.
     OpenGL::VertexLayout m_layout;
     /// Cached number of vertices, available after data are all uploaded.
     size_t m_n_vertices;
+    /// Ranges of vertices of different materials, all of them in one of no material by default.
+    std::vector<Part> m_parts;
 };
 
 // TODO maybe in the future use std::tuple for
@@ -77,6 +109,11 @@ class Mesh : public MeshBase {
         m_vertex_program = program;
         auto&& locked = OpenGL::Introspector::Get(m_vertex_program).lock();
         auto& input = locked->input();
+        auto signature = OpenGL::signature(input);
+        if (signature == m_input_signature) {
+            return;
+        }
+        m_input_signature = signature;
         m_layout.clear();
         m_layout.bind();
         auto&& provide = [this, &input](auto& vbo)
@@ -102,6 +139,7 @@ class Mesh : public MeshBase {
   private:
     using MeshBase::m_n_vertices;
     using MeshBase::m_vertex_program;
+    using MeshBase::m_input_signature;
     using MeshBase::m_layout;
 
     Owned<VertexBuffer<P>> m_positions;
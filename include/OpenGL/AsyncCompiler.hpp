@@ -0,0 +1,103 @@
+/**
+ * @File AsyncCompiler.hpp
+ * @brief Compile programs without stalling the rendering thread.
+ * @author Zhen Luo 461652354@qq.com
+ */
+#pragma once
+
+#include "Object/Program.hpp"
+#include <Utility/Misc.hpp>
+#include <Utility/Thread.hpp>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+namespace OpenGL {
+
+/// Compiles separable single stage programs, and links programs of multiple stages, in the background.
+/// @details With GL_KHR_parallel_shader_compile (or its ARB twin) the driver compiles on its own threads and
+/// completion is merely polled. Otherwise a worker thread compiles in a hidden context sharing objects with the
+/// rendering one.
+/// @note Except for the worker thread, everything happens on the thread owning the rendering context.
+class AsyncCompiler {
+  public:
+    /// Identifies a program being compiled.
+    using Ticket = std::uint64_t;
+
+    /// A stage of program: shader type and source.
+    using Stage = std::pair<GLenum, std::string>;
+
+    /// @param share Window whose context programs are shared with, needed only if the driver can't compile in
+    /// parallel by itself.
+    explicit AsyncCompiler(GLFWwindow* share);
+
+    ~AsyncCompiler();
+
+    /// Whether the driver compiles in parallel rather than a worker thread.
+    bool parallel() const
+    { return m_parallel; }
+
+    /// Start compiling @p source as a separable program of shader @p type.
+    Ticket compile(GLenum type, std::string source);
+
+    /// Start compiling @p stages and linking them into one program, not separable.
+    Ticket link(std::vector<Stage> stages);
+
+    /// @brief Take out the program of @p ticket if done.
+    /// @return The linked program, or an empty one with info log if compiling failed. Null if still compiling.
+    Shared<Program> poll(Ticket ticket);
+
+    /// Forget about the program of @p ticket.
+    void cancel(Ticket ticket);
+
+  private:
+    struct Job {
+        Ticket ticket;
+        /// One stage if separable.
+        std::vector<Stage> stages;
+        bool separable;
+    };
+
+    bool m_parallel;
+    Ticket m_next_ticket = 1;
+    /// Programs compiled in parallel by the driver, or handed over by the worker.
+    std::unordered_map<Ticket, Program> m_programs;
+
+    //region Worker thread fallback
+
+    /// Hidden window owning the context of the worker, null if compiling in parallel.
+    GLFWwindow* m_context = nullptr;
+    std::deque<Job> m_jobs;
+    /// Names of programs done by the worker, yet to be adopted into m_programs.
+    /// @note The worker hands over bare names: Program objects are only ever made and destroyed on the rendering
+    /// thread, as neither Introspector nor name pools are thread-safe.
+    std::unordered_map<Ticket, GLuint> m_done;
+    /// Names of programs done by the worker after being cancelled, to be deleted by the rendering thread.
+    std::vector<GLuint> m_discarded;
+    /// Ticket of the job the worker is on, 0 if none or cancelled.
+    Ticket m_working = 0;
+    /// Guards m_jobs, m_done, m_discarded, m_working and m_stop.
+    std::mutex mutex_jobs;
+    std::condition_variable m_jobs_changed;
+    bool m_stop = false;
+    std::thread m_worker;
+
+    void aux_work();
+
+    /// Submit @p job to the driver or the worker.
+    Ticket aux_submit(Job job);
+
+    /// Create the program of @p job, leaving compiling and linking to complete in the background.
+    static Program aux_create(const Job& job);
+
+    /// Delete programs of @p names, done by the worker but no longer wanted. Rendering thread only.
+    static void aux_delete(const std::vector<GLuint>& names);
+
+    //endregion
+};
+
+} // namespace OpenGL
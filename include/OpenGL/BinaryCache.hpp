@@ -0,0 +1,71 @@
+/**
+ * @File BinaryCache.hpp
+ * @brief Persistent cache of linked programs.
+ * @author Zhen Luo 461652354@qq.com
+ */
+#pragma once
+
+#include "Object/Program.hpp"
+#include "Introspection/Introspector.hpp"
+#include <FileSystem.hpp>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace OpenGL {
+
+/// Directory of program binaries retrieved through GL_ARB_get_program_binary.
+/// @details Each binary is stored in its own file named after its key, which identifies the sources and stages linked
+/// as well as the OpenGL implementation, so binaries of another driver are never even tried. Should a driver still
+/// reject one, e.g. after an update keeping its version string, the caller compiles as usual and stores anew.
+/// @note Programs are separable unless told otherwise, both when keyed and loaded.
+class BinaryCache {
+  public:
+    /// A stage of program: shader type and source.
+    using Stage = std::pair<GLenum, const std::string*>;
+
+    /// @brief Cache binaries in @p directory, created if missing.
+    /// @param directory Directory to use; empty to disable the cache.
+    /// @note Requires a current context.
+    explicit BinaryCache(FS::path directory);
+
+    bool enabled() const
+    { return !m_directory.empty(); }
+
+    /// Key identifying a separable program linked from @p stages on the current OpenGL implementation.
+    std::uint64_t key(std::initializer_list<Stage> stages) const
+    { return key(std::vector<Stage>(stages), true); }
+
+    /// Key identifying a program, separable or not, linked from @p stages on the current OpenGL implementation.
+    std::uint64_t key(const std::vector<Stage>& stages, bool separable) const;
+
+    /// @brief Load the program stored under @p key, separable or not as it was keyed.
+    /// @return The program, or an empty one if not stored or rejected by the driver.
+    Program load(std::uint64_t key, bool separable = true) const;
+
+    /// Store the binary of linked @p program under @p key.
+    void store(std::uint64_t key, const Program& program) const;
+
+    /// @brief Introspect @p program, loaded under @p key, from the snapshot stored alongside its binary.
+    /// @return True if introspected without querying the driver.
+    bool load_introspection(std::uint64_t key, const Program& program) const;
+
+    /// Store a snapshot of introspection of @p program alongside its binary under @p key.
+    void store_introspection(std::uint64_t key, const Program& program) const;
+
+  private:
+    FS::path m_directory;
+    /// Hash identifying the OpenGL implementation.
+    std::uint64_t m_implementation = 0;
+
+    /// Path of file under @p key, with @p extension.
+    FS::path aux_path(std::uint64_t key, const char* extension = "bin") const;
+
+    /// Write @p header and @p length bytes of @p data to @p path, atomically.
+    static void aux_write(const FS::path& path, const void* header, std::size_t header_length, const char* data,
+                          std::size_t length);
+};
+
+} // namespace OpenGL
@@ -0,0 +1,43 @@
+/**
+ * @File Headless.hpp
+ * @brief OpenGL contexts without any window or display.
+ * @author Zhen Luo 461652354@qq.com
+ */
+#pragma once
+
+#include "Common.hpp"
+#include <string>
+
+
+namespace OpenGL {
+
+/// Core profile context of the configured version on an EGL surfaceless display, e.g. Mesa llvmpipe on a server.
+/// @details Contexts are independent of each other and of GLFW, so that each thread may own one. The OpenGL loader
+/// is initialized the first time any of them is made current.
+/// @note Requires EGL with EGL_MESA_platform_surfaceless; otherwise no context is ever valid.
+class HeadlessContext {
+  public:
+    HeadlessContext();
+
+    ~HeadlessContext();
+
+    HeadlessContext(const HeadlessContext&) = delete;
+    HeadlessContext& operator=(const HeadlessContext&) = delete;
+
+    bool valid() const
+    { return m_context != nullptr; }
+
+    /// Why the context is not valid.
+    const std::string& error() const
+    { return m_error; }
+
+    /// Make this context current on the calling thread.
+    /// @return False on failure.
+    bool make_current();
+
+  private:
+    void* m_context = nullptr;
+    std::string m_error;
+};
+
+} // namespace OpenGL
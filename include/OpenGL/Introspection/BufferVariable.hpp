@@ -0,0 +1,50 @@
+/**
+ * @File BufferVariable.hpp
+ * @author Zhen Luo 461652354@qq.com
+ */
+#pragma once
+
+#include <ostream>
+#include "Resource.hpp"
+#include <Utility/Debug.hpp>
+
+
+namespace OpenGL {
+
+/// A member of a shader storage block.
+struct BufferVariable : public Resource {
+    static constexpr GLenum interface = GL_BUFFER_VARIABLE;
+
+    GLint type = 0;
+    GLint asize = 0;
+    GLint offset = -1;
+    GLint block_index = -1;
+    GLint astride = -1;
+    GLint mstride = -1;
+    GLint row_major = false;
+    /// Array size of the top level member of the block this is (in), 0 if unsized, e.g. the last one.
+    GLint top_level_asize = 0;
+    GLint top_level_astride = 0;
+    GLint referenced[MaxShaderStage] = {};
+
+    using GLintfield = GLint(BufferVariable::*);
+    static constexpr GLintfield fields[] =
+            {&BufferVariable::type, &BufferVariable::asize, &BufferVariable::offset, &BufferVariable::block_index,
+             &BufferVariable::astride, &BufferVariable::mstride, &BufferVariable::row_major,
+             &BufferVariable::top_level_asize, &BufferVariable::top_level_astride,};
+    static constexpr size_t n_fields = numel(fields);
+
+    static constexpr GLenum properties[] =
+            {GL_TYPE, GL_ARRAY_SIZE, GL_OFFSET, GL_BLOCK_INDEX, GL_ARRAY_STRIDE, GL_MATRIX_STRIDE, GL_IS_ROW_MAJOR,
+             GL_TOP_LEVEL_ARRAY_SIZE, GL_TOP_LEVEL_ARRAY_STRIDE, GL_REFERENCED_BY_VERTEX_SHADER,
+             GL_REFERENCED_BY_TESS_CONTROL_SHADER, GL_REFERENCED_BY_TESS_EVALUATION_SHADER,
+             GL_REFERENCED_BY_GEOMETRY_SHADER, GL_REFERENCED_BY_FRAGMENT_SHADER, GL_REFERENCED_BY_COMPUTE_SHADER,};
+    static constexpr size_t n_properties = numel(properties);
+    static_assert(n_fields + MaxShaderStage == n_properties);
+
+    BufferVariable(GLuint program, GLint index, std::string_view name, const GLint* values);
+
+    friend std::ostream& operator<<(std::ostream& os, const BufferVariable& variable);
+};
+
+} // namespace OpenGL
@@ -9,9 +9,15 @@
 #include "../Object/Program.hpp"
 #include "ProgramInput.hpp"
 #include "ProgramOutput.hpp"
+#include "InterfaceData.hpp"
+#include "ResourceIndex.hpp"
 #include "Uniform.hpp"
 #include "UniformBlock.hpp"
+#include "BufferVariable.hpp"
+#include "ShaderStorageBlock.hpp"
 #include "SubroutineUniform.hpp"
+#include <algorithm>
+#include <numeric>
 
 
 namespace OpenGL {
@@ -35,6 +41,7 @@ struct InterfaceBase {
  */
 template <typename Resource>
 struct ProgramInterface : public details::InterfaceBase {
+    using resource_type = Resource;
     static constexpr GLenum interface = Resource::interface;
     static constexpr bool InterfaceResourceNamed =
             !(interface == GL_ATOMIC_COUNTER_BUFFER || interface == GL_TRANSFORM_FEEDBACK_BUFFER);
@@ -50,55 +57,60 @@ struct ProgramInterface : public details::InterfaceBase {
                                                  interface == GL_COMPUTE_SUBROUTINE_UNIFORM);
 
     std::vector<Resource> resources;
+    /// Active subroutines of the stage, indexed by subroutine index. Only for subroutine uniform interfaces.
+    std::vector<OpenGL::Resource> subroutines;
 
-    explicit ProgramInterface(GLuint name)
+    /// @brief Introspect all resources of the interface of program @p name.
+    /// @details Every resource is queried once: one glGetProgramResourceiv fetches its properties together with the
+    /// length of its name and any variable length list, i.e. active variables of blocks or compatible subroutines of
+    /// subroutine uniforms; one glGetProgramResourceName writes its name straight into an arena shared by all names
+    /// of the interface.
+    /// @param context Passed on to constructors of resources, e.g. uniforms of the program for uniform blocks.
+    template <typename ...Context>
+    explicit ProgramInterface(GLuint name, const Context& ...context) : m_data(aux_query(name))
+    { aux_build(name, context...); }
+
+    /// @brief Rebuild the interface of program @p name from @p data, as previously queried, without querying.
+    /// @param context Passed on to constructors of resources, e.g. uniforms of the program for uniform blocks.
+    template <typename ...Context>
+    ProgramInterface(GLuint name, details::InterfaceData data, const Context& ...context) : m_data(std::move(data))
+    { aux_build(name, context...); }
+
+    /// Data the interface is built of, e.g. to write a snapshot of.
+    const details::InterfaceData& data() const
+    { return m_data; }
+
+    /// Total length of names of resources, including null terminators.
+    std::size_t names_size() const
+    { return m_data.names_size; }
+
+    /// @brief Whether @p data could have been queried of this interface, as far as its layout tells.
+    /// @note Says nothing of whether the program is the same.
+    static bool Consistent(const details::InterfaceData& data)
     {
-        // per interface properties
-        GLint n_resources;
-        glGetProgramInterfaceiv(name, interface, GL_ACTIVE_RESOURCES, &n_resources);
-        if (InterfaceResourceNamed) {
-            glGetProgramInterfaceiv(name, interface, GL_MAX_NAME_LENGTH, &max_name_length);
+        if (data.stride < n_props - n_listed || (!InterfaceSubroutine && !data.subroutine_name_lengths.empty())) {
+            return false;
         }
-        if (InterfaceMultipleVariables) {
-            glGetProgramInterfaceiv(name, interface, GL_MAX_NUM_ACTIVE_VARIABLES, &max_n_variables);
+        std::size_t size = 0;
+        for (auto length : data.subroutine_name_lengths) {
+            size += std::max(length, 1);
         }
-        if (InterfaceSubroutine) {
-            glGetProgramInterfaceiv(name, interface, GL_MAX_NUM_COMPATIBLE_SUBROUTINES, &max_n_compatible_subroutines);
-        }
-        resources.reserve(n_resources);
-        // properties of resources in this interface
-        const GLint n_props = Resource::n_properties;
-        const GLenum* props = Resource::properties;
-        GLint values[Resource::n_properties];
-        auto&& name_buffer = std::make_unique<GLchar[]>(max_name_length);
-        for (GLint i = 0; i < n_resources; ++i) {
-            glGetProgramResourceiv(name, interface, i, n_props, props, n_props, nullptr, values);
-            if (InterfaceResourceNamed) {
-                glGetProgramResourceName(name, interface, i, max_name_length, nullptr, name_buffer.get());
-                resources.emplace_back(name, i, name_buffer.get(), values);
-            } else {
-                resources.emplace_back(name, i, nullptr, values);
-            }
+        for (GLint i = 0; i < data.n_resources && InterfaceResourceNamed; ++i) {
+            size += std::max(data.row(i)[0], 1);
         }
+        return size == data.names_size;
     }
 
-    const Resource* find(const std::string& name) const
-    { return find(name.c_str()); }
-
-    const Resource* find(const char* name) const
+    /// Find a resource by name, in constant time and without allocating.
+    const Resource* find(const ResourceKey& name) const
     {
-        std::string str(name);
-        for (auto& r : resources) {
-            if (r.name == str) {
-                return &r;
-            }
-        }
+        auto position = m_index.find(resources, name);
         // Log::d("In {}, {} not found\n", type_name<decltype(*this)>(), name);
-        return nullptr;
+        return position == details::ResourceIndex::npos ? nullptr : &resources[position];
     }
 
     template <typename ...Args>
-    void assign(const char* name, Args... args) const
+    void assign(const ResourceKey& name, Args... args) const
     {
         auto R = find(name);
         if (!R) {
@@ -109,7 +121,7 @@ struct ProgramInterface : public details::InterfaceBase {
     }
 
     template <typename ...Args>
-    void assign(GLuint program, const char* name, Args... args) const
+    void assign(GLuint program, const ResourceKey& name, Args... args) const
     {
         auto R = find(name);
         if (!R) {
@@ -127,10 +139,121 @@ struct ProgramInterface : public details::InterfaceBase {
         }
         return os;
     }
+
+  private:
+    /// Hash index of resources by name.
+    details::ResourceIndex m_index;
+    /// Everything queried, which resources and subroutines are views of.
+    details::InterfaceData m_data;
+
+    // properties of resources in this interface, preceded by length of name and followed by the list, if any
+    static constexpr GLint n_named = InterfaceResourceNamed ? 1 : 0;
+    static constexpr GLint n_listed = InterfaceMultipleVariables || InterfaceSubroutine ? 1 : 0;
+    static constexpr GLint n_props = n_named + Resource::n_properties + n_listed;
+
+    /// Query everything of the interface of program @p name.
+    static details::InterfaceData aux_query(GLuint name)
+    {
+        details::InterfaceData data;
+        // per interface properties
+        glGetProgramInterfaceiv(name, interface, GL_ACTIVE_RESOURCES, &data.n_resources);
+        if (InterfaceResourceNamed) {
+            glGetProgramInterfaceiv(name, interface, GL_MAX_NAME_LENGTH, &data.max_name_length);
+        }
+        if (InterfaceMultipleVariables) {
+            glGetProgramInterfaceiv(name, interface, GL_MAX_NUM_ACTIVE_VARIABLES, &data.max_n_variables);
+        }
+        if (InterfaceSubroutine) {
+            glGetProgramInterfaceiv(name, interface, GL_MAX_NUM_COMPATIBLE_SUBROUTINES,
+                                    &data.max_n_compatible_subroutines);
+        }
+        // per resource properties
+        GLenum props[n_props];
+        if (InterfaceResourceNamed) {
+            props[0] = GL_NAME_LENGTH;
+        }
+        std::copy_n(Resource::properties, Resource::n_properties, props + n_named);
+        if (InterfaceMultipleVariables) {
+            props[n_props - 1] = GL_ACTIVE_VARIABLES;
+        } else if (InterfaceSubroutine) {
+            props[n_props - 1] = GL_COMPATIBLE_SUBROUTINES;
+        }
+        data.stride = n_props - n_listed + std::max(data.max_n_variables, data.max_n_compatible_subroutines);
+        data.values.resize(static_cast<std::size_t>(data.n_resources) * data.stride);
+        for (GLint i = 0; i < data.n_resources; ++i) {
+            glGetProgramResourceiv(name, interface, i, n_props, props, data.stride, nullptr,
+                                   &data.values[i * data.stride]);
+            data.names_size += n_named ? data.row(i)[0] : 0;
+        }
+        if constexpr (InterfaceSubroutine) {
+            constexpr GLenum length_props[] = {GL_NAME_LENGTH};
+            GLint n_subroutines = 0;
+            glGetProgramInterfaceiv(name, Resource::subroutine_interface, GL_ACTIVE_RESOURCES, &n_subroutines);
+            data.subroutine_name_lengths.resize(n_subroutines);
+            for (GLint i = 0; i < n_subroutines; ++i) {
+                glGetProgramResourceiv(name, Resource::subroutine_interface, i, 1, length_props, 1, nullptr,
+                                       &data.subroutine_name_lengths[i]);
+            }
+            data.names_size += std::accumulate(data.subroutine_name_lengths.begin(),
+                                               data.subroutine_name_lengths.end(), 0);
+        }
+        // names, of subroutines first
+        data.names = std::make_unique<GLchar[]>(data.names_size);
+        GLchar* names = data.names.get();
+        if constexpr (InterfaceSubroutine) {
+            for (GLint i = 0; i < static_cast<GLint>(data.subroutine_name_lengths.size()); ++i) {
+                auto size = data.subroutine_name_lengths[i];
+                glGetProgramResourceName(name, Resource::subroutine_interface, i, size, nullptr, names);
+                names += size;
+            }
+        }
+        for (GLint i = 0; i < data.n_resources && InterfaceResourceNamed; ++i) {
+            auto size = data.row(i)[0];
+            glGetProgramResourceName(name, interface, i, size, nullptr, names);
+            names += size;
+        }
+        return data;
+    }
+
+    /// Make subroutines and resources of m_data.
+    template <typename ...Context>
+    void aux_build(GLuint name, const Context& ...context)
+    {
+        max_name_length = m_data.max_name_length;
+        max_n_variables = m_data.max_n_variables;
+        max_n_compatible_subroutines = m_data.max_n_compatible_subroutines;
+        // names are null terminated, whose lengths, as told by GL_NAME_LENGTH, include the terminator
+        const GLchar* names = m_data.names.get();
+        auto&& next_name = [&names](GLint size)
+        {
+            std::string_view view(names, std::max(size, 1) - 1);
+            names += std::max(size, 1);
+            return view;
+        };
+        subroutines.reserve(m_data.subroutine_name_lengths.size());
+        for (GLint i = 0; i < static_cast<GLint>(m_data.subroutine_name_lengths.size()); ++i) {
+            subroutines.emplace_back(i, next_name(m_data.subroutine_name_lengths[i]));
+        }
+        resources.reserve(m_data.n_resources);
+        for (GLint i = 0; i < m_data.n_resources; ++i) {
+            const GLint* v = m_data.row(i);
+            auto resource_name = InterfaceResourceNamed ? next_name(v[0]) : std::string_view();
+            if constexpr (InterfaceSubroutine) {
+                resources.emplace_back(name, i, resource_name, v + n_named, subroutines);
+            } else {
+                resources.emplace_back(name, i, resource_name, v + n_named, context...);
+            }
+        }
+        if (InterfaceResourceNamed) {
+            m_index.build(resources);
+        }
+    }
 };
 
 using UniformInterface = ProgramInterface<Uniform>;
 using UniformBlockInterface = ProgramInterface<UniformBlock>;
+using BufferVariableInterface = ProgramInterface<BufferVariable>;
+using ShaderStorageBlockInterface = ProgramInterface<ShaderStorageBlock>;
 using ProgramInputInterface = ProgramInterface<ProgramInput>;
 using ProgramOutputInterface = ProgramInterface<ProgramOutput>;
 using VertexSubroutineUniformInterface = ProgramInterface<VertexSubroutineUniform>;
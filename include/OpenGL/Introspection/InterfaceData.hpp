@@ -0,0 +1,51 @@
+/**
+ * @File InterfaceData.hpp
+ * @brief What the driver answers introspecting an interface, before resources are made of it.
+ * @author Zhen Luo 461652354@qq.com
+ */
+#pragma once
+
+#include "../Common.hpp"
+#include <Utility/Misc.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace OpenGL {
+
+namespace details {
+
+/// @brief Raw introspection data of a program interface.
+/// @details Kept by ProgramInterface, whose resources are views of it, so that it can be written to a snapshot and
+/// read back later to rebuild the same resources without querying the driver.
+struct InterfaceData {
+    GLint n_resources = 0;
+    /// Number of values per resource.
+    GLint stride = 0;
+    GLint max_name_length = 0;
+    GLint max_n_variables = 0;
+    GLint max_n_compatible_subroutines = 0;
+    /// Values of properties of resources, @p stride per resource.
+    std::vector<GLint> values;
+    /// Lengths of names of active subroutines of the stage, including null terminators. Only for subroutine uniforms.
+    std::vector<GLint> subroutine_name_lengths;
+    /// Names of subroutines then resources, each null terminated.
+    Owned<GLchar[]> names;
+    std::size_t names_size = 0;
+
+    /// Values of the resource at @p index.
+    const GLint* row(GLint index) const
+    { return values.data() + static_cast<std::size_t>(index) * stride; }
+
+    /// Append this to @p out.
+    void write(std::string& out) const;
+
+    /// @brief Read what write() wrote from the head of @p in, and advance it past.
+    /// @return False if @p in is truncated or inconsistent.
+    bool read(std::string_view& in);
+};
+
+} // namespace details
+
+} // namespace OpenGL
@@ -0,0 +1,91 @@
+/**
+ * @File InterfaceDiff.hpp
+ * @brief What changed between interfaces of a program and its reloaded successor.
+ * @author Zhen Luo 461652354@qq.com
+ */
+#pragma once
+
+#include "Interface.hpp"
+#include <Utility/Hash.hpp>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace OpenGL {
+
+/// Structural difference between an interface of a program and the same interface of another, typically the one
+/// reloaded from edited sources.
+/// @details Resources are matched by name. Those matched keep their type and array size, possibly at another location;
+/// the rest are either added, removed or retyped.
+struct InterfaceDiff {
+    std::vector<std::string> added;
+    std::vector<std::string> removed;
+    /// Same name, different type or array size.
+    std::vector<std::string> retyped;
+    /// Same name, type and array size, at a different location.
+    std::vector<std::string> moved;
+    /// Indices of resources of the same name, type and array size in the interfaces before and after, moved or not.
+    std::vector<std::pair<GLint, GLint>> matched;
+
+    /// Whether resources are all matched and none moved.
+    bool empty() const
+    { return added.empty() && removed.empty() && retyped.empty() && moved.empty(); }
+
+    /// Short summary, e.g. "+1 -0 ~2 >0" for one added, two retyped.
+    std::string summary() const;
+};
+
+/// @brief Diff interfaces @p before and @p after, of resources with type, array size and location.
+template <typename Resource>
+InterfaceDiff
+diff(const ProgramInterface<Resource>& before, const ProgramInterface<Resource>& after)
+{
+    InterfaceDiff diff;
+    for (auto&& b : before.resources) {
+        auto* a = after.find(b.name);
+        if (!a) {
+            diff.removed.emplace_back(b.name);
+        } else if (a->type != b.type || a->asize != b.asize) {
+            diff.retyped.emplace_back(b.name);
+        } else {
+            if (a->location != b.location) {
+                diff.moved.emplace_back(b.name);
+            }
+            diff.matched.emplace_back(b.index, a->index);
+        }
+    }
+    for (auto&& a : after.resources) {
+        if (!before.find(a.name)) {
+            diff.added.emplace_back(a.name);
+        }
+    }
+    return diff;
+}
+
+/// @brief Hash of names, types, array sizes and locations of all resources of @p interface.
+/// @details Equal for interfaces any vertex layout or uniform location works for alike, e.g. inputs of a vertex
+/// shader before and after editing nothing but its logic.
+template <typename Resource>
+std::uint64_t
+signature(const ProgramInterface<Resource>& interface)
+{
+    std::uint64_t hash = interface.resources.size();
+    for (auto&& r : interface.resources) {
+        hash = hash_combine(hash, hash_name(r.name));
+        hash = hash_combine(hash, static_cast<std::uint64_t>(r.type));
+        hash = hash_combine(hash, static_cast<std::uint64_t>(r.asize));
+        hash = hash_combine(hash, static_cast<std::uint64_t>(r.location));
+    }
+    return hash;
+}
+
+/// @brief Copy values of uniforms of @p from to uniforms matched in @p to, as told by @p uniforms.
+/// @details Uniforms in blocks, whose values live in buffers, are left alone. Values copied bypass the UniformShadow
+/// of @p to, which forgets what it recorded of them lest uploads of other values be skipped as redundant.
+/// @param uniforms Diff of uniform interfaces of @p from and @p to.
+/// @return Number of uniforms copied.
+std::size_t
+carry_uniforms(const Program& from, const Program& to, const InterfaceDiff& uniforms);
+
+} // namespace OpenGL
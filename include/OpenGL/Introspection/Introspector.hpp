@@ -5,6 +5,7 @@
 #pragma once
 
 #include "Interface.hpp"
+#include "UniformShadow.hpp"
 #include <unordered_map>
 
 
@@ -18,12 +19,25 @@ class Introspector {
     static Weak<Introspector> Get(GLuint program);
     static void Put(const Program& program);
 
+    /// @brief Serialize every interface of @p program, introspecting those not yet.
+    /// @return A compact binary snapshot to Restore() from.
+    static std::string Snapshot(const Program& program);
+
+    /// @brief Introspect @p program from @p snapshot, taken of a program of the same binary, without querying the
+    /// driver for every resource.
+    /// @details Numbers of active resources of each interface are checked against the program; on any mismatch, or
+    /// if @p snapshot is malformed, nothing is restored and the program will be introspected live as usual.
+    /// @return True if restored, or already introspected.
+    static bool Restore(const Program& program, std::string_view snapshot);
+
     ~Introspector() = default;
 
     /// A weak reference to program object
     const GLuint name;
     /// debug label; could be empty string
     const std::string label;
+    /// Values last uploaded to uniforms of the program by UniformHandle.
+    details::UniformShadow uniform_shadow;
 
     const ProgramInterface<Uniform>& uniform() const
     {
@@ -36,11 +50,27 @@ class Introspector {
     const ProgramInterface<UniformBlock>& uniform_block() const
     {
         if (!IUniformBlock) {
-            IUniformBlock = std::make_unique<UniformBlockInterface>(name);
+            IUniformBlock = std::make_unique<UniformBlockInterface>(name, uniform().resources);
         }
         return *IUniformBlock;
     }
 
+    const ProgramInterface<BufferVariable>& buffer_variable() const
+    {
+        if (!IBufferVariable) {
+            IBufferVariable = std::make_unique<BufferVariableInterface>(name);
+        }
+        return *IBufferVariable;
+    }
+
+    const ProgramInterface<ShaderStorageBlock>& shader_storage_block() const
+    {
+        if (!IShaderStorageBlock) {
+            IShaderStorageBlock = std::make_unique<ShaderStorageBlockInterface>(name, buffer_variable().resources);
+        }
+        return *IShaderStorageBlock;
+    }
+
     const ProgramInterface<ProgramInput>& input() const
     {
         if (!IInput) {
@@ -114,8 +144,28 @@ class Introspector {
 
     explicit Introspector(const Program& program);
 
+    /// Call @p f with each interface of all, even if not introspected yet, variables before blocks of them.
+    template <typename F>
+    void aux_for_each_interface(F&& f)
+    {
+        f(IUniform);
+        f(IUniformBlock);
+        f(IBufferVariable);
+        f(IShaderStorageBlock);
+        f(IInput);
+        f(IOutput);
+        f(IVertexSubroutineUniform);
+        f(ITessControlSubroutineUniform);
+        f(ITessEvaluationSubroutineUniform);
+        f(IGeometrySubroutineUniform);
+        f(IFragmentSubroutineUniform);
+        f(IComputeSubroutineUniform);
+    }
+
     mutable Owned<UniformInterface> IUniform;
     mutable Owned<UniformBlockInterface> IUniformBlock;
+    mutable Owned<BufferVariableInterface> IBufferVariable;
+    mutable Owned<ShaderStorageBlockInterface> IShaderStorageBlock;
     mutable Owned<ProgramInputInterface> IInput;
     mutable Owned<ProgramOutputInterface> IOutput;
     mutable Owned<VertexSubroutineUniformInterface> IVertexSubroutineUniform;
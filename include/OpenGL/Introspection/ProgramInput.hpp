@@ -35,7 +35,7 @@ struct ProgramInput : public Resource {
     static constexpr size_t n_properties{numel(properties)};
     static_assert(n_fields + MaxShaderStage == n_properties);
 
-    ProgramInput(GLuint program, GLint index, GLchar* name, const GLint* values);
+    ProgramInput(GLuint program, GLint index, std::string_view name, const GLint* values);
 
     friend std::ostream& operator<<(std::ostream& os, const ProgramInput& input);
 
@@ -37,7 +37,7 @@ struct ProgramOutput : public Resource {
     static constexpr size_t n_properties = numel(properties);
     static_assert(n_fields + MaxShaderStage == n_properties, "");
 
-    ProgramOutput(GLuint program, GLint index, GLchar* name, const GLint* values);
+    ProgramOutput(GLuint program, GLint index, std::string_view name, const GLint* values);
 
     friend std::ostream& operator<<(std::ostream& os, const ProgramOutput& output);
 
@@ -6,18 +6,20 @@
 
 #include "../Common.hpp"
 #include "../Constants.hpp"
+#include <string_view>
 
 
 namespace OpenGL {
 
 struct Resource {
     GLint index = 0;
-    std::string name;
+    /// Name of the resource, a view of names kept by the ProgramInterface it belongs to.
+    std::string_view name;
 
     explicit Resource(GLint index) : index(index)
     {}
 
-    Resource(GLint index, GLchar* name) : index(index), name(name)
+    Resource(GLint index, std::string_view name) : index(index), name(name)
     {}
 
     friend std::ostream& operator<<(std::ostream& os, const Resource& resource);
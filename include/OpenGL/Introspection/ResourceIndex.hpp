@@ -0,0 +1,101 @@
+/**
+ * @File ResourceIndex.hpp
+ * @brief Lookup of program resources by name.
+ * @author Zhen Luo 461652354@qq.com
+ */
+#pragma once
+
+#include <Utility/Hash.hpp>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace OpenGL {
+
+/// Name of a program resource paired with its hash_name(), computed at compile time where possible.
+/// @details Declare keys used every frame as constexpr, e.g.
+/// @code
+/// static constexpr OpenGL::ResourceKey u_time("u_time");
+/// @endcode
+/// so that looking them up neither hashes nor allocates.
+struct ResourceKey {
+    std::string_view name;
+    std::uint64_t hash;
+
+    constexpr ResourceKey(std::string_view name) noexcept : name(name), hash(hash_name(name))
+    {}
+
+    constexpr ResourceKey(const char* name) noexcept : ResourceKey(std::string_view(name))
+    {}
+
+    ResourceKey(const std::string& name) noexcept : ResourceKey(std::string_view(name))
+    {}
+};
+
+namespace details {
+
+/// Open addressing hash table from names of resources to their positions in a vector.
+/// @details Slots are a power of two at least twice the number of resources and probed linearly, so lookups touch
+/// one or two slots in a single cache line most of the time. Names themselves stay in the resources.
+class ResourceIndex {
+  public:
+    /// Position returned for names not found.
+    static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+    /// Index every element of @p resources, which must have a 'name' member.
+    template <typename Resources>
+    void build(const Resources& resources)
+    {
+        std::size_t capacity = 4;
+        while (capacity < 2 * resources.size()) {
+            capacity *= 2;
+        }
+        m_slots.assign(capacity, {0, Empty});
+        m_mask = capacity - 1;
+        for (std::size_t i = 0; i < resources.size(); ++i) {
+            auto hash = hash_name(resources[i].name);
+            auto slot = hash & m_mask;
+            while (m_slots[slot].position != Empty) {
+                slot = (slot + 1) & m_mask;
+            }
+            m_slots[slot] = {hash, static_cast<std::uint32_t>(i)};
+        }
+    }
+
+    /// @brief Position of the resource named @p key in @p resources, the same ones indexed by build().
+    /// @return Position, or npos if not found.
+    template <typename Resources>
+    std::size_t find(const Resources& resources, const ResourceKey& key) const
+    {
+        if (m_slots.empty()) {
+            return npos;
+        }
+        for (auto slot = key.hash & m_mask;; slot = (slot + 1) & m_mask) {
+            auto&& entry = m_slots[slot];
+            if (entry.position == Empty) {
+                return npos;
+            }
+            if (entry.hash == key.hash && resources[entry.position].name == key.name) {
+                return entry.position;
+            }
+        }
+    }
+
+  private:
+    static constexpr std::uint32_t Empty = std::numeric_limits<std::uint32_t>::max();
+
+    struct Slot {
+        std::uint64_t hash;
+        std::uint32_t position;
+    };
+
+    std::vector<Slot> m_slots;
+    std::size_t m_mask = 0;
+};
+
+} // namespace details
+
+} // namespace OpenGL
@@ -0,0 +1,41 @@
+/**
+ * @File ShaderStorageBlock.hpp
+ * @author Zhen Luo 461652354@qq.com
+ */
+#pragma once
+
+#include "BufferVariable.hpp"
+#include <vector>
+
+
+namespace OpenGL {
+
+struct ShaderStorageBlock : public Resource {
+    static constexpr GLenum interface = GL_SHADER_STORAGE_BLOCK;
+
+    GLint binding = -1;
+    /// Minimum size of buffer bound to the block, with any unsized array at the end having one element.
+    GLint size = 0;
+    GLint referenced[MaxShaderStage] = {};
+    /// Member buffer variables, owned by the buffer variable interface of the program.
+    std::vector<const BufferVariable*> variables;
+
+    static constexpr GLenum properties[] =
+            {GL_BUFFER_BINDING, GL_BUFFER_DATA_SIZE, GL_NUM_ACTIVE_VARIABLES,
+             GL_REFERENCED_BY_VERTEX_SHADER, GL_REFERENCED_BY_TESS_CONTROL_SHADER,
+             GL_REFERENCED_BY_TESS_EVALUATION_SHADER, GL_REFERENCED_BY_GEOMETRY_SHADER,
+             GL_REFERENCED_BY_FRAGMENT_SHADER, GL_REFERENCED_BY_COMPUTE_SHADER,};
+    static constexpr size_t n_properties = numel(properties);
+
+    /// @param values Values of properties, followed by indices of member buffer variables.
+    /// @param program_variables All buffer variables of the program, by index.
+    ShaderStorageBlock(GLuint program, GLint index, std::string_view name, const GLint* values,
+                       const std::vector<BufferVariable>& program_variables);
+
+    const BufferVariable* find(std::string_view name) const;
+
+    friend std::ostream& operator<<(std::ostream& os, const ShaderStorageBlock& block);
+
+};
+
+} // namespace OpenGL
@@ -0,0 +1,96 @@
+/**
+ * @File SubroutineSelection.hpp
+ * @brief Subroutines selected for subroutine uniforms by name, loaded whenever programs are bound.
+ * @author Zhen Luo 461652354@qq.com
+ */
+#pragma once
+
+#include "Introspector.hpp"
+#include <map>
+#include <string>
+#include <vector>
+
+
+namespace OpenGL {
+
+/// Call @p f with the subroutine uniform interface of @p stage of @p introspector.
+template <typename F>
+decltype(auto)
+visit_subroutine_uniforms(const Introspector& introspector, ShaderStage stage, F&& f)
+{
+    switch (stage) {
+        case ShaderStage::Vertex:
+            return f(introspector.vertex_subroutine_uniform());
+        case ShaderStage::TessellationControl:
+            return f(introspector.tess_control_subroutine_uniform());
+        case ShaderStage::TessellationEvaluation:
+            return f(introspector.tess_evaluation_subroutine_uniform());
+        case ShaderStage::Geometry:
+            return f(introspector.geometry_subroutine_uniform());
+        case ShaderStage::Fragment:
+            return f(introspector.fragment_subroutine_uniform());
+        case ShaderStage::Compute:
+            return f(introspector.compute_subroutine_uniform());
+        default:
+            UNREACHABLE;
+    }
+}
+
+/// @brief Subroutines selected for subroutine uniforms of a shader stage.
+/// @details Both are kept by name rather than index, so that a selection survives the programs it applies to being
+/// edited and reloaded, as long as they keep declaring them. Subroutine uniforms not selected for, or selected for
+/// a subroutine they're not compatible with, take their first compatible subroutine.
+class SubroutineSelection {
+  public:
+    /// Select @p subroutine for subroutine uniform @p uniform.
+    void select(const std::string& uniform, const std::string& subroutine);
+
+    /// Forget what was selected for subroutine uniform @p uniform.
+    void deselect(const std::string& uniform);
+
+    /// Forget all selected.
+    void clear();
+
+    /// Names of subroutines selected, by names of subroutine uniforms.
+    const std::map<std::string, std::string, std::less<>>& selected() const
+    { return m_selected; }
+
+    /// Incremented as the selection changes.
+    unsigned version() const
+    { return m_version; }
+
+    /// Subroutine @p uniform takes, null if it has no compatible subroutine.
+    const Resource* subroutine(const SubroutineUniform& uniform) const;
+
+  private:
+    std::map<std::string, std::string, std::less<>> m_selected;
+    unsigned m_version = 0;
+};
+
+/// @brief Subroutine indices a SubroutineSelection tells for one stage of one program, loaded with
+/// glUniformSubroutinesuiv.
+/// @details Subroutine uniforms are context state rather than program state: the GL forgets them whenever a program
+/// is used for their stage, be it by glUseProgram, glBindProgramPipeline or glUseProgramStages on the pipeline bound,
+/// and apply() has to be called again after each. Indices are resolved again only when the program, its
+/// introspection data or the selection change.
+class SubroutineBinding {
+  public:
+    /// @brief Resolve against @p stage of @p program if needed, and load subroutines @p selection tells for it.
+    /// @details @p program must be the one in use for @p stage. Does nothing if the stage has no active subroutine
+    /// uniform.
+    void apply(const Program& program, ShaderStage stage, const SubroutineSelection& selection);
+
+  private:
+    void aux_resolve(const Program& program, ShaderStage stage, const SubroutineSelection& selection);
+
+    GLuint m_program = 0;
+    ShaderStage m_stage = ShaderStage::Max;
+    /// Introspection data of m_program; once expired, the program is gone and its name may be reused.
+    Weak<Introspector> m_introspector;
+    /// Version of the selection resolved.
+    unsigned m_version = 0;
+    /// Subroutine index of each subroutine uniform location of m_stage, empty if none.
+    std::vector<GLuint> m_indices;
+};
+
+} // namespace OpenGL
@@ -19,11 +19,15 @@ struct SubroutineUniform : public Resource {
   public:
     GLint asize = 0;
     GLint location = -1;
+    /// Subroutines compatible with this subroutine uniform.
     std::vector<Subroutine> subroutines;
-    static constexpr GLenum properties[] = {GL_ARRAY_SIZE, GL_LOCATION,};
+    static constexpr GLenum properties[] = {GL_ARRAY_SIZE, GL_LOCATION, GL_NUM_COMPATIBLE_SUBROUTINES,};
     static constexpr size_t n_properties = numel(properties);
 
-    SubroutineUniform(GLuint program, GLenum stage, GLint index, GLchar* name, const GLint* values);
+    /// @param values Values of properties, followed by indices of compatible subroutines.
+    /// @param stage_subroutines All active subroutines of the stage, by index.
+    SubroutineUniform(GLuint program, GLint index, std::string_view name, const GLint* values,
+                      const std::vector<Subroutine>& stage_subroutines);
 
     friend std::ostream& operator<<(std::ostream& os, const SubroutineUniform& sub_uniform);
 
@@ -32,54 +36,66 @@ struct SubroutineUniform : public Resource {
 struct VertexSubroutineUniform : public SubroutineUniform {
     static constexpr GLenum interface = GL_VERTEX_SUBROUTINE_UNIFORM;
     static constexpr GLenum stage = GL_VERTEX_SHADER;
+    static constexpr GLenum subroutine_interface = GL_VERTEX_SUBROUTINE;
 
-    VertexSubroutineUniform(GLuint program, GLint index, GLchar* name, GLint* values)
-            : SubroutineUniform(program, stage, index, name, values)
+    VertexSubroutineUniform(GLuint program, GLint index, std::string_view name, const GLint* values,
+                            const std::vector<Subroutine>& stage_subroutines)
+            : SubroutineUniform(program, index, name, values, stage_subroutines)
     {}
 };
 
 struct TessControlSubroutineUniform : public SubroutineUniform {
     static constexpr GLenum interface = GL_TESS_CONTROL_SUBROUTINE_UNIFORM;
     static constexpr GLenum stage = GL_TESS_CONTROL_SHADER;
+    static constexpr GLenum subroutine_interface = GL_TESS_CONTROL_SUBROUTINE;
 
-    TessControlSubroutineUniform(GLuint program, GLint index, GLchar* name, GLint* values)
-            : SubroutineUniform(program, stage, index, name, values)
+    TessControlSubroutineUniform(GLuint program, GLint index, std::string_view name, const GLint* values,
+                                 const std::vector<Subroutine>& stage_subroutines)
+            : SubroutineUniform(program, index, name, values, stage_subroutines)
     {}
 };
 
 struct TessEvaluationSubroutineUniform : public SubroutineUniform {
     static constexpr GLenum interface = GL_TESS_EVALUATION_SUBROUTINE_UNIFORM;
     static constexpr GLenum stage = GL_TESS_EVALUATION_SHADER;
+    static constexpr GLenum subroutine_interface = GL_TESS_EVALUATION_SUBROUTINE;
 
-    TessEvaluationSubroutineUniform(GLuint program, GLint index, GLchar* name, GLint* values)
-            : SubroutineUniform(program, stage, index, name, values)
+    TessEvaluationSubroutineUniform(GLuint program, GLint index, std::string_view name, const GLint* values,
+                                    const std::vector<Subroutine>& stage_subroutines)
+            : SubroutineUniform(program, index, name, values, stage_subroutines)
     {}
 };
 
 struct GeometrySubroutineUniform : public SubroutineUniform {
     static constexpr GLenum interface = GL_GEOMETRY_SUBROUTINE_UNIFORM;
     static constexpr GLenum stage = GL_GEOMETRY_SHADER;
+    static constexpr GLenum subroutine_interface = GL_GEOMETRY_SUBROUTINE;
 
-    GeometrySubroutineUniform(GLuint program, GLint index, GLchar* name, GLint* values)
-            : SubroutineUniform(program, stage, index, name, values)
+    GeometrySubroutineUniform(GLuint program, GLint index, std::string_view name, const GLint* values,
+                              const std::vector<Subroutine>& stage_subroutines)
+            : SubroutineUniform(program, index, name, values, stage_subroutines)
     {}
 };
 
 struct FragmentSubroutineUniform : public SubroutineUniform {
     static constexpr GLenum interface = GL_FRAGMENT_SUBROUTINE_UNIFORM;
     static constexpr GLenum stage = GL_FRAGMENT_SHADER;
+    static constexpr GLenum subroutine_interface = GL_FRAGMENT_SUBROUTINE;
 
-    FragmentSubroutineUniform(GLuint program, GLint index, GLchar* name, GLint* values)
-            : SubroutineUniform(program, stage, index, name, values)
+    FragmentSubroutineUniform(GLuint program, GLint index, std::string_view name, const GLint* values,
+                              const std::vector<Subroutine>& stage_subroutines)
+            : SubroutineUniform(program, index, name, values, stage_subroutines)
     {}
 };
 
 struct ComputeSubroutineUniform : public SubroutineUniform {
     static constexpr GLenum interface = GL_COMPUTE_SUBROUTINE_UNIFORM;
     static constexpr GLenum stage = GL_COMPUTE_SHADER;
+    static constexpr GLenum subroutine_interface = GL_COMPUTE_SUBROUTINE;
 
-    ComputeSubroutineUniform(GLuint program, GLint index, GLchar* name, GLint* values)
-            : SubroutineUniform(program, stage, index, name, values)
+    ComputeSubroutineUniform(GLuint program, GLint index, std::string_view name, const GLint* values,
+                             const std::vector<Subroutine>& stage_subroutines)
+            : SubroutineUniform(program, index, name, values, stage_subroutines)
     {}
 };
 } // namespace OpenGL
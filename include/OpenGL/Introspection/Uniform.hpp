@@ -520,7 +520,7 @@ struct Uniform : public Resource {
              GL_REFERENCED_BY_GEOMETRY_SHADER, GL_REFERENCED_BY_FRAGMENT_SHADER, GL_REFERENCED_BY_COMPUTE_SHADER,};
     static constexpr size_t n_properties = numel(properties);
 
-    Uniform(GLuint program, GLint index, GLchar* name, const GLint* values);
+    Uniform(GLuint program, GLint index, std::string_view name, const GLint* values);
 
     friend std::ostream& operator<<(std::ostream& os, const Uniform& uniform);
 
@@ -530,7 +530,7 @@ struct Uniform : public Resource {
     template <typename ...Args, typename = std::enable_if_t<details::all_GL_type_v<Args...>>>
     void assign(Args... args) const noexcept
     {
-        // TODO check type & size against recorded data type
+        // unchecked; UniformHandle checks type & size against recorded data type once per program
         details::glUniformxx(location, std::forward<Args>(args)...);
     }
 
@@ -584,7 +584,7 @@ struct Uniform : public Resource {
     template <typename ...Args, typename = std::enable_if_t<details::all_GL_type_v<Args...>>>
     void assign(GLuint program, Args... args) const noexcept
     {
-        // TODO check type & size against recorded data type
+        // unchecked; UniformHandle checks type & size against recorded data type once per program
         details::glProgramUniformxx(program, location, std::forward<Args>(args)...);
     }
 
@@ -16,7 +16,8 @@ struct UniformBlock : public Resource {
     GLint binding = -1;
     GLint size = 0;
     GLint referenced[MaxShaderStage] = {};
-    std::vector<Uniform> uniforms;
+    /// Member uniforms, owned by the uniform interface of the program.
+    std::vector<const Uniform*> uniforms;
 
     static constexpr GLenum properties[] =
             {GL_BUFFER_BINDING, GL_BUFFER_DATA_SIZE, GL_NUM_ACTIVE_VARIABLES,
@@ -25,9 +26,12 @@ struct UniformBlock : public Resource {
              GL_REFERENCED_BY_FRAGMENT_SHADER, GL_REFERENCED_BY_COMPUTE_SHADER,};
     static constexpr size_t n_properties = numel(properties);
 
-    UniformBlock(GLuint program, GLint index, GLchar* name, const GLint* values);
+    /// @param values Values of properties, followed by indices of member uniforms.
+    /// @param program_uniforms All uniforms of the program, by index.
+    UniformBlock(GLuint program, GLint index, std::string_view name, const GLint* values,
+                 const std::vector<Uniform>& program_uniforms);
 
-    const Uniform* find(const char* name) const;
+    const Uniform* find(std::string_view name) const;
 
     friend std::ostream& operator<<(std::ostream& os, const UniformBlock& block);
 
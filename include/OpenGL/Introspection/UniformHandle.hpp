@@ -0,0 +1,302 @@
+/**
+ * @File UniformHandle.hpp
+ * @brief Typed uniforms resolved once per program link.
+ * @author Zhen Luo 461652354@qq.com
+ */
+#pragma once
+
+#include "Introspector.hpp"
+#include <array>
+#include <memory>
+
+
+namespace OpenGL {
+
+namespace details {
+
+//region Uniform type traits
+
+/// Data type of uniforms GLSL declares as @p L components of @p C.
+template <typename C>
+constexpr GLenum
+uniform_vector_type(glm::length_t L)
+{
+    constexpr GLenum types[][4] = {
+            {GL_FLOAT, GL_FLOAT_VEC2, GL_FLOAT_VEC3, GL_FLOAT_VEC4},
+            {GL_DOUBLE, GL_DOUBLE_VEC2, GL_DOUBLE_VEC3, GL_DOUBLE_VEC4},
+            {GL_INT, GL_INT_VEC2, GL_INT_VEC3, GL_INT_VEC4},
+            {GL_UNSIGNED_INT, GL_UNSIGNED_INT_VEC2, GL_UNSIGNED_INT_VEC3, GL_UNSIGNED_INT_VEC4},
+    };
+    if constexpr (std::is_same_v<C, GLfloat>) {
+        return types[0][L - 1];
+    } else if constexpr (std::is_same_v<C, GLdouble>) {
+        return types[1][L - 1];
+    } else if constexpr (std::is_same_v<C, GLint>) {
+        return types[2][L - 1];
+    } else {
+        static_assert(std::is_same_v<C, GLuint>, "Components of uniforms must be float, double, int or uint");
+        return types[3][L - 1];
+    }
+}
+
+/// Data type of uniforms GLSL declares as matrices of @p Cols columns and @p Rows rows of @p C.
+template <typename C>
+constexpr GLenum
+uniform_matrix_type(glm::length_t Cols, glm::length_t Rows)
+{
+    constexpr GLenum types[][3][3] = {
+            {{GL_FLOAT_MAT2, GL_FLOAT_MAT2x3, GL_FLOAT_MAT2x4},
+                    {GL_FLOAT_MAT3x2, GL_FLOAT_MAT3, GL_FLOAT_MAT3x4},
+                    {GL_FLOAT_MAT4x2, GL_FLOAT_MAT4x3, GL_FLOAT_MAT4}},
+            {{GL_DOUBLE_MAT2, GL_DOUBLE_MAT2x3, GL_DOUBLE_MAT2x4},
+                    {GL_DOUBLE_MAT3x2, GL_DOUBLE_MAT3, GL_DOUBLE_MAT3x4},
+                    {GL_DOUBLE_MAT4x2, GL_DOUBLE_MAT4x3, GL_DOUBLE_MAT4}},
+    };
+    static_assert(std::is_same_v<C, GLfloat> || std::is_same_v<C, GLdouble>,
+                  "Elements of matrix uniforms must be float or double");
+    return types[std::is_same_v<C, GLdouble>][Cols - 2][Rows - 2];
+}
+
+/// How a C++ type @p T maps to uniforms.
+/// @details Defined for GLfloat, GLdouble, GLint, GLuint, glm vectors and matrices of them, and std::array of all
+/// those. Other types are rejected at compile time.
+template <typename T>
+struct UniformTraits;
+
+template <typename T>
+struct UniformScalarTraits {
+    using element = T;
+    using component = T;
+    static constexpr GLenum type = uniform_vector_type<T>(1);
+    static constexpr glm::length_t components = 1;
+    static constexpr glm::length_t columns = 1;
+    static constexpr GLsizei count = 1;
+};
+
+template <>
+struct UniformTraits<GLfloat> : UniformScalarTraits<GLfloat> {};
+
+template <>
+struct UniformTraits<GLdouble> : UniformScalarTraits<GLdouble> {};
+
+template <>
+struct UniformTraits<GLint> : UniformScalarTraits<GLint> {};
+
+template <>
+struct UniformTraits<GLuint> : UniformScalarTraits<GLuint> {};
+
+template <glm::length_t L, typename T, glm::qualifier Q>
+struct UniformTraits<glm::vec<L, T, Q>> {
+    using element = glm::vec<L, T, Q>;
+    using component = T;
+    static constexpr GLenum type = uniform_vector_type<T>(L);
+    static constexpr glm::length_t components = L;
+    static constexpr glm::length_t columns = 1;
+    static constexpr GLsizei count = 1;
+};
+
+template <glm::length_t C, glm::length_t R, typename T, glm::qualifier Q>
+struct UniformTraits<glm::mat<C, R, T, Q>> {
+    using element = glm::mat<C, R, T, Q>;
+    using component = T;
+    static constexpr GLenum type = uniform_matrix_type<T>(C, R);
+    static constexpr glm::length_t components = R;
+    static constexpr glm::length_t columns = C;
+    static constexpr GLsizei count = 1;
+};
+
+template <typename T, std::size_t N>
+struct UniformTraits<std::array<T, N>> : UniformTraits<T> {
+    static_assert(UniformTraits<T>::count == 1, "Arrays of arrays are not uniforms");
+    static constexpr GLsizei count = N;
+};
+
+/// Whether uniforms declared as @p declared could be assigned values of @p supplied with glProgramUniform*.
+/// @details Besides identical types, booleans take float, int and uint of the same number of components, and
+/// samplers and images take int.
+bool
+uniform_accepts(GLenum declared, GLenum supplied);
+
+//endregion
+
+/// @brief Mimics glProgramUniform*v and glProgramUniformMatrix*v.
+/// @param count Number of contiguous elements pointed to by @p values.
+template <typename E>
+inline void
+glProgramUniformxxv(GLuint program, GLint location, GLsizei count, const E* values)
+{
+    using Traits = UniformTraits<E>;
+    using C = typename Traits::component;
+    auto v = reinterpret_cast<const C*>(values);
+    if constexpr (Traits::columns > 1) {
+        UNUSED(v);
+        if constexpr (std::is_same_v<C, GLfloat>) {
+            return glProgramUniformMatrixxfv(program, location, count, GL_FALSE, *values);
+        } else {
+            return glProgramUniformMatrixxdv(program, location, count, GL_FALSE, *values);
+        }
+    } else if constexpr (std::is_same_v<C, GLfloat>) {
+        switch (Traits::components) {
+            case 1:
+                return glProgramUniform1fv(program, location, count, v);
+            case 2:
+                return glProgramUniform2fv(program, location, count, v);
+            case 3:
+                return glProgramUniform3fv(program, location, count, v);
+            case 4:
+                return glProgramUniform4fv(program, location, count, v);
+            default:
+                break;
+        }
+    } else if constexpr (std::is_same_v<C, GLint>) {
+        switch (Traits::components) {
+            case 1:
+                return glProgramUniform1iv(program, location, count, v);
+            case 2:
+                return glProgramUniform2iv(program, location, count, v);
+            case 3:
+                return glProgramUniform3iv(program, location, count, v);
+            case 4:
+                return glProgramUniform4iv(program, location, count, v);
+            default:
+                break;
+        }
+    } else if constexpr (std::is_same_v<C, GLuint>) {
+        switch (Traits::components) {
+            case 1:
+                return glProgramUniform1uiv(program, location, count, v);
+            case 2:
+                return glProgramUniform2uiv(program, location, count, v);
+            case 3:
+                return glProgramUniform3uiv(program, location, count, v);
+            case 4:
+                return glProgramUniform4uiv(program, location, count, v);
+            default:
+                break;
+        }
+    } else if constexpr (std::is_same_v<C, GLdouble>) {
+        switch (Traits::components) {
+            case 1:
+                return glProgramUniform1dv(program, location, count, v);
+            case 2:
+                return glProgramUniform2dv(program, location, count, v);
+            case 3:
+                return glProgramUniform3dv(program, location, count, v);
+            case 4:
+                return glProgramUniform4dv(program, location, count, v);
+            default:
+                break;
+        }
+    }
+    UNREACHABLE;
+}
+
+/// Untyped part of UniformHandle: resolving the uniform against introspection data of a program.
+class UniformHandleBase {
+  public:
+    /// Name of the uniform.
+    const ResourceKey& key() const
+    { return m_key; }
+
+    /// Program the handle was last resolved against, 0 if never.
+    GLuint program() const
+    { return m_program; }
+
+    /// Location of the uniform in program(), -1 if it is not active or not compatible.
+    GLint location() const
+    { return m_location; }
+
+    /// Whether the uniform was found active and compatible when last resolved.
+    bool valid() const
+    { return m_location != -1; }
+
+  protected:
+    /// @param type Data type the handle supplies.
+    /// @param count Number of elements the handle supplies.
+    UniformHandleBase(const ResourceKey& key, GLenum type, GLsizei count) noexcept
+            : m_key(key), m_type(type), m_count(count), m_elements(count)
+    {}
+
+    /// Whether the handle was resolved against @p program, and its introspection data is still the same.
+    bool aux_resolved(const Program& program) const
+    { return m_program == program.name() && !m_introspector.expired(); }
+
+    /// Look up the uniform in @p program and check its type and array size against those supplied.
+    bool aux_resolve(const Program& program);
+
+    /// Whether @p size bytes at @p data differ from the value last uploaded to the uniform, recording them if so.
+    bool aux_changed(const void* data, std::size_t size) const
+    { return m_shadow->update(m_location, data, size); }
+
+    ResourceKey m_key;
+    GLenum m_type;
+    /// Number of elements supplied.
+    GLsizei m_count;
+    /// Number of elements assigned, m_count clamped to array size of the uniform.
+    GLsizei m_elements;
+    GLuint m_program = 0;
+    GLint m_location = -1;
+    /// Introspection data of m_program; once expired, the program is gone and its name may be reused.
+    Weak<Introspector> m_introspector;
+    /// Shadow state of m_program, owned by m_introspector and valid as long as it is.
+    UniformShadow* m_shadow = nullptr;
+};
+
+} // namespace details
+
+/// @brief A uniform of type @p T, looked up and type checked once per program rather than every assignment.
+/// @details Resolving a handle against a program finds the uniform by name in the introspection data of the program,
+/// checks @p T against its declared type and array size, and records its location; assignment then goes straight to
+/// glProgramUniform*, skipped if the value is the same as last uploaded to the program by any handle, as its
+/// UniformShadow tells. Handles notice when the program they're used with changes, or when its Introspector is
+/// replaced as programs are destroyed, and resolve again by themselves.
+/// @code
+/// OpenGL::UniformHandle<float> u_time{"u_time"};
+/// u_time.assign(program, static_cast<float>(glfwGetTime()));
+/// @endcode
+/// @tparam T Type of values: GLfloat, GLdouble, GLint, GLuint, glm vectors and matrices of them, or std::array of all
+/// those for uniform arrays, whose name ends with "[0]" then.
+template <typename T>
+class UniformHandle : public details::UniformHandleBase {
+    using Traits = details::UniformTraits<T>;
+
+  public:
+    /// @param name Name of the uniform, must outlive the handle, e.g. a string literal.
+    explicit UniformHandle(const ResourceKey& name) noexcept
+            : UniformHandleBase(name, Traits::type, Traits::count)
+    {}
+
+    /// @brief Resolve against @p program, unless already did.
+    /// @return True if the uniform is active in @p program and takes values of @p T.
+    bool resolve(const Program& program)
+    {
+        if (aux_resolved(program)) {
+            return valid();
+        }
+        return aux_resolve(program);
+    }
+
+    /// @brief Assign @p value to the uniform in the program last resolved against, unless it is the value last
+    /// assigned already. Does nothing if not valid(), or if the program is gone.
+    void assign(const T& value) const
+    {
+        if (m_location == -1 || m_introspector.expired()) {
+            return;
+        }
+        using E = typename Traits::element;
+        auto elements = reinterpret_cast<const E*>(&value);
+        if (aux_changed(elements, sizeof(E) * m_elements)) {
+            details::glProgramUniformxxv(m_program, m_location, m_elements, elements);
+        }
+    }
+
+    /// Resolve against @p program if needed, then assign @p value to the uniform.
+    void assign(const Program& program, const T& value)
+    {
+        if (resolve(program)) {
+            assign(value);
+        }
+    }
+};
+
+} // namespace OpenGL
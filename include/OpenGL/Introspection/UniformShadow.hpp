@@ -0,0 +1,60 @@
+/**
+ * @File UniformShadow.hpp
+ * @brief Values of uniforms of a program as last uploaded, to skip uploading them again.
+ * @author Zhen Luo 461652354@qq.com
+ */
+#pragma once
+
+#include "../Common.hpp"
+#include <cstdint>
+#include <vector>
+
+
+namespace OpenGL {
+
+/// Numbers of uniform uploads issued and skipped as redundant, by all UniformHandle of all programs.
+struct UniformUploads {
+    std::uint64_t issued = 0;
+    std::uint64_t skipped = 0;
+};
+
+namespace details {
+
+/// @brief Shadow copy of values last uploaded to uniforms of a program, by location.
+/// @details Kept by the Introspector of the program, hence discarded with it. Only values uploaded through
+/// UniformHandle are recorded; anything assigned otherwise is not seen, and may be overwritten by an upload wrongly
+/// taken as redundant.
+class UniformShadow {
+  public:
+    /// @brief Record @p size bytes at @p data as the value at @p location, counting the upload as issued or skipped.
+    /// @return False if it is what was last recorded at @p location, and need not be uploaded again.
+    bool update(GLint location, const void* data, std::size_t size);
+
+    /// @brief Forget the value recorded at @p location, e.g. once it's assigned other than through UniformHandle, so
+    /// that the next upload to it is issued whatever the value.
+    void forget(GLint location)
+    {
+        if (location >= 0 && static_cast<std::size_t>(location) < m_values.size()) {
+            m_values[location].clear();
+        }
+    }
+
+    /// Forget all values recorded.
+    void clear()
+    { m_values.clear(); }
+
+    /// Counters of all uploads.
+    static UniformUploads& Uploads()
+    {
+        static UniformUploads uploads;
+        return uploads;
+    }
+
+  private:
+    /// Bytes of values indexed by location, empty if none recorded. Locations are small, and dense unless explicit.
+    std::vector<std::vector<unsigned char>> m_values;
+};
+
+} // namespace details
+
+} // namespace OpenGL
@@ -61,6 +61,20 @@ class Program : public Object {
     explicit Program(GLenum type, std::initializer_list<std::string> sources) : Object(Standalone(type, sources))
     { aux_check_link(); }
 
+    /// Tag a program as 'do not wait for it to link upon construction'.
+    struct Deferred {};
+
+    /// Like Program(GLenum, std::initializer_list<std::string>), but check() it once completed().
+    Program(GLenum type, std::initializer_list<std::string> sources, Deferred) : Object(Standalone(type, sources))
+    {}
+
+    /// Tag a program as 'take over a name created elsewhere', e.g. released by another thread.
+    struct Adopt {};
+
+    /// Take over program @p name, as returned by release().
+    Program(GLuint name, Adopt) : Object(Name(name))
+    {}
+
     Program(Program&&) = default;
     Program& operator=(Program&&) = default;
 
@@ -82,12 +96,45 @@ class Program : public Object {
     /// Link all attached shaders together, forming a valid program.
     Program& link();
 
+    /// Like link(), but check() it once completed().
+    Program& link(Deferred);
+
+    /// Whether linking has completed; never blocks if GL_KHR_parallel_shader_compile is supported, otherwise true.
+    bool completed() const;
+
+    /// Check link status of a completed program. If failed, program name is released and info log is stored.
+    Program& check()
+    {
+        aux_check_link();
+        return *this;
+    }
+
+    /// Load a program binary previously retrieved by get_binary(), replacing linking.
+    /// @note If rejected, e.g. by a different driver, program name is released as if linking failed.
+    Program& binary(GLenum format, const void* binary, GLsizei length);
+
+    /// Retrieve the binary of a linked program.
+    /// @param [out] format Receives the format of the binary.
+    /// @return The binary, empty if the implementation doesn't provide one.
+    std::vector<char> get_binary(GLenum& format) const;
+
     Program& use()
     {
         Use(*this);
         return *this;
     }
 
+    /// @brief Give up the name of the program without deleting it, leaving an empty program.
+    /// @details An empty program touches neither its Introspector nor OpenGL when destroyed, so a thread other than
+    /// the rendering one can create a program and hand over its name, to be adopted by the rendering thread.
+    /// @return The name, to be adopted with Program(GLuint, Adopt).
+    GLuint release()
+    {
+        GLuint name = m_name.get();
+        m_name = Name();
+        return name;
+    }
+
     Weak<Introspector> interfaces() const;
 
     /// Query about a parameter
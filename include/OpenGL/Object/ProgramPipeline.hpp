@@ -6,11 +6,17 @@
 
 #include "Program.hpp"
 #include "../Constants.hpp"
+#include <array>
+#include <string>
 
 
 namespace OpenGL {
 
 /// OpenGL program pipeline object
+/// @details It records the program used for each stage, so that using the same programs again is free, and caches
+/// the result of validation until any stage changes.
+/// @note A program must outlive its use in a pipeline, lest its name be reused by another program and fool the
+/// record. Programs that may go away should be used through Shared pointers, which the pipeline holds on to.
 class ProgramPipeline : Object {
     static auto& pool()
     {
@@ -39,10 +45,19 @@ class ProgramPipeline : Object {
         return *this;
     }
 
+    /// Use @p program for stages in @p bits, unless already used.
     ProgramPipeline& use_stage(const Program& program, GLbitfield bits);
 
+    /// Use @p program for stages in @p bits, unless already used, holding on to it meanwhile. Null to use none.
+    ProgramPipeline& use_stage(const Shared<Program>& program, GLbitfield bits);
+
+    /// Validate the pipeline, unless stages didn't change since last time; see info_log() if invalid.
     bool valid() const;
 
+    /// Info log of the last validation.
+    const std::string& info_log() const
+    { return m_info_log; }
+
     ProgramPipeline& bind()
     {
         Bind(*this);
@@ -59,6 +74,18 @@ class ProgramPipeline : Object {
 
     std::unique_ptr<GLchar[]> get_info_log() const;
 
+  private:
+    /// Name of the program used for each stage, 0 if none.
+    std::array<GLuint, MaxShaderStage> m_stages{};
+    /// Programs used that are held on to.
+    std::array<Shared<Program>, MaxShaderStage> m_held{};
+    mutable bool m_validated = false;
+    mutable bool m_valid = false;
+    mutable std::string m_info_log;
+
+    /// Record @p name as used for stages in @p bits.
+    /// @return False if it's already used for all of them.
+    bool aux_record(GLuint name, GLbitfield bits);
 };
 
 } // namespace OpenGL
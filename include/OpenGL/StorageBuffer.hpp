@@ -0,0 +1,85 @@
+/**
+ * @File StorageBuffer.hpp
+ * @brief A shader storage buffer the CPU rewrites every frame without waiting for draws still reading it.
+ * @author Zhen Luo 461652354@qq.com
+ */
+#pragma once
+
+#include "Object/Buffer.hpp"
+#include <Utility/Misc.hpp>
+#include <vector>
+
+
+namespace OpenGL {
+
+/// @brief A shader storage block of fixed size for large structured data written by the CPU every frame, e.g.
+/// thousands of lights or particles, backed by a buffer of several slots written in turn.
+/// @details Like UniformRing, each next() moves on to the slot after the current one, waiting on its fence in case
+/// the GPU lags that far behind, so that what is written never races draws still reading an earlier frame.
+/// With GL_ARB_buffer_storage, or OpenGL 4.4, the store is immutable and mapped once, persistent and coherent: writes
+/// reach the GPU as they are, without copying. Otherwise writes go to memory of the CPU, uploaded by flush().
+class StorageBuffer {
+  public:
+    /// @param size Size of the block in bytes.
+    /// @param n_slots Number of slots, i.e. frames the GPU may lag behind.
+    explicit StorageBuffer(GLsizeiptr size, GLsizei n_slots = 3);
+
+    StorageBuffer(const StorageBuffer&) = delete;
+    StorageBuffer& operator=(const StorageBuffer&) = delete;
+
+    ~StorageBuffer();
+
+    /// Whether the store is mapped persistent and coherent, and flush() does nothing.
+    bool persistent() const
+    { return m_staging == nullptr; }
+
+    /// Size of the block in bytes.
+    GLsizeiptr size() const
+    { return m_size; }
+
+    /// @brief Move on to the next slot, which becomes current.
+    /// @details Commands issued so far, e.g. draws of the last frame, are taken to be all that read the slot current
+    /// until now.
+    /// @return Memory to write the block to, as data(). What it holds is undefined; write all that is to be read.
+    void* next();
+
+    /// Memory to write the block of the current slot to, valid until next().
+    void* data() const
+    { return m_staging ? m_staging.get() : m_mapped + offset(); }
+
+    /// data() as @p T, e.g. the header of a block laid out in std430.
+    template <typename T>
+    T* as() const
+    { return static_cast<T*>(data()); }
+
+    /// @brief Make @p length bytes written from @p offset of the current slot visible to commands issued after,
+    /// unless persistent().
+    /// @param length Number of bytes, or -1 for all to the end of the block.
+    void flush(GLintptr offset = 0, GLsizeiptr length = -1);
+
+    /// Bind the current slot to shader storage buffer binding point @p binding.
+    void bind(GLuint binding) const
+    { glBindBufferRange(GL_SHADER_STORAGE_BUFFER, binding, m_buffer.name(), offset(), m_size); }
+
+    /// Offset of the current slot in the buffer.
+    GLintptr offset() const
+    { return m_current * m_stride; }
+
+    const Buffer& buffer() const
+    { return m_buffer; }
+
+  private:
+    Buffer m_buffer;
+    GLsizeiptr m_size;
+    /// Size of the block rounded up to GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT.
+    GLsizeiptr m_stride;
+    GLsizei m_current;
+    /// Fences of commands last issued reading each slot, null if none.
+    std::vector<GLsync> m_fences;
+    /// The whole store mapped, if persistent.
+    unsigned char* m_mapped = nullptr;
+    /// The block on CPU, if the store can't be mapped persistently.
+    Owned<unsigned char[]> m_staging;
+};
+
+} // namespace OpenGL
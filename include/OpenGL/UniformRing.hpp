@@ -0,0 +1,63 @@
+/**
+ * @File UniformRing.hpp
+ * @brief A uniform buffer rewritten every frame without waiting for draws still reading it.
+ * @author Zhen Luo 461652354@qq.com
+ */
+#pragma once
+
+#include "Object/Buffer.hpp"
+#include <type_traits>
+#include <vector>
+
+
+namespace OpenGL {
+
+/// @brief A uniform block of fixed size, backed by a buffer of several slots written in turn.
+/// @details Each write() goes to the slot after the current one, which the GPU was done reading frames ago, so
+/// writing never stalls on draws in flight; a fence per slot makes sure of it when the GPU lags further behind.
+class UniformRing {
+  public:
+    /// @param size Size of the block in bytes.
+    /// @param n_slots Number of slots, i.e. frames the GPU may lag behind.
+    explicit UniformRing(GLsizeiptr size, GLsizei n_slots = 3);
+
+    UniformRing(const UniformRing&) = delete;
+    UniformRing& operator=(const UniformRing&) = delete;
+
+    ~UniformRing();
+
+    /// @brief Write the block into the next slot, which becomes current.
+    /// @details Commands issued so far, e.g. draws of the last frame, are taken to be all that read the slot current
+    /// until now.
+    void write(const void* data);
+
+    template <typename T>
+    void write(const T& block)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        assert(sizeof(T) == m_size);
+        write(static_cast<const void*>(&block));
+    }
+
+    /// Bind the current slot to uniform buffer binding point @p binding.
+    void bind(GLuint binding) const
+    { glBindBufferRange(GL_UNIFORM_BUFFER, binding, m_buffer.name(), offset(), m_size); }
+
+    /// Offset of the current slot in the buffer.
+    GLintptr offset() const
+    { return m_current * m_stride; }
+
+    const Buffer& buffer() const
+    { return m_buffer; }
+
+  private:
+    Buffer m_buffer;
+    GLsizeiptr m_size;
+    /// Size of the block rounded up to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT.
+    GLsizeiptr m_stride;
+    GLsizei m_current;
+    /// Fences of commands last issued reading each slot, null if none.
+    std::vector<GLsync> m_fences;
+};
+
+} // namespace OpenGL
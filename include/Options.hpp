@@ -46,14 +46,38 @@ struct GlobalOptions {
         bool always_on_top = false;
     } window;
 
+    /// File watching options
+    struct Watch {
+        /// Time a burst of events on a file must go quiet for before it's reloaded, in milliseconds.
+        float settle = 20.0f;
+        /// Glob patterns of directory trees to watch for new shaders.
+        std::vector<std::string> trees;
+    } watch;
+
     /// OpenGL specific options
     struct OpenGL {
         struct Version {
             int major = OPENGL_MAJOR_VERSION;
             int minor = OPENGL_MINOR_VERSION;
         } version;
+        /// Maximum number of shader variants remembered, see Sandbox::m_variants.
+        std::size_t variants = 256;
+        /// Maximum memory, in bytes, taken by linked programs kept resident.
+        std::size_t resident_memory = 64 << 20;
+        /// Link user stages into one non-separable program rather than a pipeline of separable ones?
+        bool monolithic = false;
+        /// Directory to cache program binaries in; empty to disable.
+        FS::path cache_dir;
     } opengl;
 
+    /// Batch validation options
+    struct Validate {
+        /// Directory of shaders to validate instead of viewing; empty if not validating.
+        FS::path directory;
+        /// Number of threads compiling; 0 for all hardware threads.
+        unsigned jobs = 0;
+    } validate;
+
     /// Various boolean flags
     struct Flags {
         /// Window is resizable?
@@ -0,0 +1,116 @@
+/**
+ * @File Preprocessor.hpp
+ * @brief Front end preparing shader sources for compilation.
+ * @author Zhen Luo 461652354@qq.com
+ */
+#pragma once
+
+#include "FileSystem.hpp"
+#include "LineMap.hpp"
+#include "Utility/Expected.hpp"
+#include "Utility/Hash.hpp"
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+
+/// Shader source ready to be compiled.
+struct PreprocessedSource {
+    /// The final source string.
+    std::string source;
+    /// Files the source is made of, in order of first inclusion; the first one being the file preprocessed.
+    FS::FileList files;
+    /// Where each line of source comes from, as indices into files and line numbers.
+    LineMap lines;
+};
+
+/// In-memory contents of shader source files.
+/// @details Files are read from disk once and kept until invalidated, e.g. when the watcher reports them updated.
+class SourceFiles {
+  public:
+    struct File {
+        std::string content;
+        /// hash64() of content.
+        std::uint64_t hash;
+    };
+
+    /// Obtain the content of @p path, reading it from disk if not cached yet.
+    /// @return Expected pointer to the cached file, valid until it's invalidated. Unexpected message string if it
+    /// can't be read.
+    expected<const File*, std::string> get(const FS::path& path);
+
+    /// Forget the content of @p path, so that it's read again next time.
+    void invalidate(const FS::path& path)
+    { m_files.erase(path); }
+
+  private:
+    std::unordered_map<FS::path, File> m_files;
+};
+
+/// @brief Scan a shader for the files it directly includes, recognizing '#include' exactly as Preprocessor does.
+/// @param file The <B>canonical</B> path to the shader.
+/// @param files Contents of files, through which @p file is read.
+/// @return <B>Canonical</B> paths to files directly included, in order of appearance and without duplicates.
+/// Unexpected message string if the file can not be read.
+/// @note Includes that can not be resolved are skipped, Preprocessor will complain about them.
+expected<FS::FileList, std::string>
+scan_includes(const FS::path& file, SourceFiles& files);
+
+/// Single pass GLSL preprocessor.
+/// @details It does only what the GLSL compiler can't do by itself:
+/// - insert '#define's of macros right below the '#version' directive;
+/// - expand '#include "file"' (or '#pragma include "file"') into the content of the file, recursively, recording in
+///   a LineMap where each line comes from so that compiler messages can be mapped back to the original files.
+/// No '#line' directive is emitted: its meaning changed between GLSL versions, and drivers report source string
+/// numbers rather than files anyway.
+/// Each file is included at most once; cyclic includes are errors. Directives inside block comments are ignored.
+/// Everything else is copied verbatim in large spans, never line by line.
+/// @note The include mechanism here is <B>NOT</B> that in ARB_shading_language_include.
+/// Concretely, here we really do query the filesystem on OS for the files we include,
+/// while the extension can only "#include" files already uploaded to OpenGL.
+/// @sa <a href="https://www.khronos.org/registry/OpenGL/extensions/ARB/ARB_shading_language_include.txt">ARB_shading_language_include Registry</a>
+class Preprocessor {
+  public:
+    /// A preprocessor reading files directly from disk.
+    Preprocessor() = default;
+
+    /// A preprocessor reading files through @p files, which must outlive it.
+    explicit Preprocessor(SourceFiles& files) : m_files(&files)
+    {}
+
+    /// Define a macro for the next preprocessed sources.
+    /// @param macro "NAME" or "NAME=VALUE".
+    void define(const std::string& macro);
+
+    /// Define every macro in @p macros.
+    template <typename Range>
+    void define_all(const Range& macros)
+    {
+        for (auto&& macro : macros) {
+            define(macro);
+        }
+    }
+
+    /// Hash of the macros defined, identifying the set of them.
+    std::uint64_t defines_hash() const
+    { return hash64(m_defines); }
+
+    /// Preprocess the shader @p file.
+    /// @return Expected preprocessed source. Unexpected message string if any file can't be read or resolved, or if
+    /// includes are cyclic.
+    expected<PreprocessedSource, std::string> process(const FS::path& file) const;
+
+  private:
+    /// Cached file contents; null to read from disk.
+    SourceFiles* m_files = nullptr;
+    /// '#define' lines for every defined macro.
+    std::string m_defines;
+    /// Number of lines in m_defines.
+    std::size_t m_define_count = 0;
+
+    struct State;
+
+    /// Append the content of file number @p index to the output.
+    /// @return Unexpected message string on failure.
+    expected<void, std::string> aux_expand(State& state, std::size_t index) const;
+};
@@ -5,9 +5,18 @@
 #pragma once
 
 #include "Mesh.hpp"
+#include "Options.hpp"
+#include "IncludeGraph.hpp"
+#include "Preprocessor.hpp"
 #include "Scene/Camera.hpp"
 #include "Watcher.hpp"
 #include "OpenGL/Constants.hpp"
+#include "OpenGL/AsyncCompiler.hpp"
+#include "OpenGL/BinaryCache.hpp"
+#include "OpenGL/Introspection/SubroutineSelection.hpp"
+#include "OpenGL/Introspection/UniformHandle.hpp"
+#include "OpenGL/StorageBuffer.hpp"
+#include "OpenGL/UniformRing.hpp"
 #include "OpenGL/Object/Buffer.hpp"
 #include "OpenGL/Object/ProgramPipeline.hpp"
 #include "OpenGL/Object/Texture.hpp"
@@ -15,6 +24,8 @@
 #include "OpenGL/Object/VertexArray.hpp"
 #include "OpenGL/Object/Framebuffer.hpp"
 #include "Window.hpp"
+#include "Utility/LRUCache.hpp"
+#include <map>
 
 
 /// Contains everything... for now
@@ -28,7 +39,11 @@ class Sandbox {
         camera.set_aspect(static_cast<float>(fbsize.x) / fbsize.y);
     }
 
-    void import(ImportedFile file, bool add_to_watch = false);
+    void import(const ImportedFile& file, bool add_to_watch = false);
+
+    /// @brief Install programs compiled in the background as they complete, and write built-in uniforms of the frame.
+    /// Called once per frame before rendering.
+    void update();
 
     /// Recompile all shaders using cached sources, when it's not the source that's updated.
     void recompile_all();
@@ -53,6 +68,40 @@ class Sandbox {
     /// @return The aforementioned list.
     std::vector<std::pair<GLuint, std::string>> programs();
 
+    /// GPU time taken to render user meshes in a link mode.
+    struct Timing {
+        std::string mode;
+        unsigned frames;
+        double min_ms;
+        double median_ms;
+        double mean_ms;
+    };
+
+    /// @brief Render user meshes @p frames times with each of the separable pipeline and the monolithic program,
+    /// timing them with GL_TIME_ELAPSED queries.
+    /// @return Timing of each mode that could render; the monolithic program is left out until linked.
+    std::vector<Timing> benchmark(unsigned frames);
+
+    /// @brief Select @p subroutine for subroutine uniform @p uniform of shaders of @p stage, loaded every time they
+    /// are bound.
+    /// @details Checked against programs currently using @p stage, see stage_programs(), and kept as they're
+    /// reloaded.
+    /// @return Unexpected message string if none of them declares such a subroutine uniform compatible with
+    /// @p subroutine.
+    expected<void, std::string>
+    select_subroutine(OpenGL::ShaderStage stage, const std::string& uniform, const std::string& subroutine);
+
+    /// Forget the subroutine selected for @p uniform of shaders of @p stage, or all of them if @p uniform is empty.
+    void deselect_subroutine(OpenGL::ShaderStage stage, const std::string& uniform);
+
+    /// Subroutines selected for shaders of @p stage.
+    const OpenGL::SubroutineSelection& subroutines(OpenGL::ShaderStage stage) const
+    { return m_subroutines[underlying_cast(stage)]; }
+
+    /// @brief Programs compiled from user sources currently using @p stage: that of user shaders of @p stage, and
+    /// background and postprocessing for the fragment stage.
+    std::vector<Shared<OpenGL::Program>> stage_programs(OpenGL::ShaderStage stage);
+
   private:
     using Empty = OpenGL::Empty;
 
@@ -63,31 +112,272 @@ class Sandbox {
         Background,
         Postprocess,
     };
+    /// @brief Uniforms useful for every shader, as laid out in std140 uniform block "Builtins".
+    /// @details Written once per frame into m_builtin_ring, bound at BuiltinBinding for all programs declaring the block.
+    struct BuiltinBlock {
+        glm::ivec4 u_viewport;
+        glm::ivec2 u_fbsize;
+        glm::ivec2 u_mpos;
+        glm::vec3 u_camera;
+        GLfloat u_time;
+        glm::vec2 u_clip;
+        glm::vec2 padding;
+        glm::mat4 PVM;
+        glm::mat4 PV;
+        glm::mat4 VM;
+        /// Columns of a mat3 are each aligned as a vec4.
+        glm::mat3x4 NM;
+    };
+    static_assert(sizeof(BuiltinBlock) == 304, "BuiltinBlock must match std140 layout of block Builtins");
+    /// Uniform buffer binding point of block "Builtins".
+    static constexpr GLuint BuiltinBinding = 0;
+
+    /// @brief A material, as laid out in std140 uniform block "Material".
+    /// @details Records of all materials of all meshes are kept in m_material_buffer, and the record of each part of a
+    /// mesh is bound at MaterialBinding before drawing it.
+    struct MaterialBlock {
+        glm::vec3 ka;
+        GLfloat shininess;
+        glm::vec3 kd;
+        GLfloat padding0;
+        glm::vec3 ks;
+        GLfloat padding1;
+    };
+    static_assert(sizeof(MaterialBlock) == 48, "MaterialBlock must match std140 layout of block Material");
+    /// Uniform buffer binding point of block "Material".
+    static constexpr GLuint MaterialBinding = 1;
+
+    /// @brief A light, as laid out in std430 in the array of buffer block "Lights".
+    struct LightRecord {
+        /// Position in view coord.
+        glm::vec3 pos;
+        GLfloat padding0;
+        glm::vec3 la;
+        GLfloat padding1;
+        glm::vec3 ld;
+        GLfloat padding2;
+        glm::vec3 ls;
+        GLfloat padding3;
+    };
+    static_assert(sizeof(LightRecord) == 64, "LightRecord must match std430 layout of struct light_t");
+    /// @brief Head of buffer block "Lights", followed by its array of lights.
+    struct LightsHeader {
+        GLuint n_lights;
+        GLuint padding[3];
+    };
+    /// Most lights block "Lights" holds.
+    static constexpr std::size_t MaxLights = 1024;
+    /// Shader storage buffer binding point of block "Lights".
+    static constexpr GLuint LightsBinding = 0;
+
+    /// @brief Uniforms useful for every shader, assigned every frame by handles resolved once per program, unless the
+    /// program declares block "Builtins" instead.
+    struct BuiltinUniforms {
+        OpenGL::UniformHandle<glm::ivec4> u_viewport{"u_viewport"};
+        OpenGL::UniformHandle<glm::ivec2> u_fbsize{"u_fbsize"};
+        OpenGL::UniformHandle<glm::ivec2> u_mpos{"u_mpos"};
+        OpenGL::UniformHandle<GLfloat> u_time{"u_time"};
+        OpenGL::UniformHandle<glm::vec3> u_camera{"u_camera"};
+        OpenGL::UniformHandle<glm::vec2> u_clip{"u_clip"};
+        OpenGL::UniformHandle<glm::mat4> PVM{"PVM"};
+        OpenGL::UniformHandle<glm::mat4> PV{"PV"};
+        OpenGL::UniformHandle<glm::mat4> VM{"VM"};
+        OpenGL::UniformHandle<glm::mat3> NM{"NM"};
+        // illumination and material, assigned when drawing meshes
+        OpenGL::UniformHandle<glm::vec3> L_pos{"L.pos"};
+        OpenGL::UniformHandle<glm::vec3> L_la{"L.la"};
+        OpenGL::UniformHandle<glm::vec3> L_ld{"L.ld"};
+        OpenGL::UniformHandle<glm::vec3> L_ls{"L.ls"};
+        OpenGL::UniformHandle<glm::vec3> M_ka{"M.ka"};
+        OpenGL::UniformHandle<glm::vec3> M_kd{"M.kd"};
+        OpenGL::UniformHandle<glm::vec3> M_ks{"M.ks"};
+        OpenGL::UniformHandle<GLfloat> M_shininess{"M.shininess"};
+        /// Program last checked for blocks "Builtins", "Material" and "Lights", and whether it declares each as laid
+        /// out, taking no loose uniforms of it.
+        GLuint block_program = 0;
+        Weak<OpenGL::Introspector> block_introspector;
+        bool builtin_block = false;
+        bool material_block = false;
+        bool lights_block = false;
+    };
+
     /// All user-specifiable program should be paired with a path leading to the corresponding shader source.
     struct ImportedProgram {
         ImportedFile file{}; // From which source of the program is read and compiled
-        OpenGL::Program program{Empty()}; // compiled separable program
+        Shared<OpenGL::Program> program{}; // compiled separable program, shared with m_resident; null if none
+        BuiltinUniforms uniforms{}; // resolved against program as it changes
+        OpenGL::SubroutineBinding subroutines{}; // resolved against program as it changes
+
+        /// Name of the program, 0 if none.
+        GLuint name() const
+        { return program ? program->name() : 0; }
     };
-    /// Compile an ImportedFile to be a single stage program and return it paired with the file.
-    static ImportedProgram aux_compile(const ImportedFile& file, OpenGL::ShaderStage stage, ShaderUsage usage);
-    /// Insert custom '#define's directly below '#version' directive
-    /// and expand '#include's into the contents of corresponding files.
-    /// @return Expected preprocessed source string. Unexpected message string if any error occurred.
-    static std::string
-    aux_preprocess_shader_source(std::string source, const std::vector<std::string>& extra_defines = {});
-
-    /// Assign a bunch of uniforms, useful for every shader.
-    static const OpenGL::ProgramInterface<OpenGL::Uniform>&
-    aux_assign_uniforms(const OpenGL::Program& program, const Scene::Camera& camera);
+    /// Binaries of programs, internal ones and user ones alike, persisting across runs.
+    OpenGL::BinaryCache m_binaries{options.opengl.cache_dir};
+
+    /// Link a separable program of internal @p stages, unless its binary is cached.
+    OpenGL::Program aux_link_internal(std::initializer_list<OpenGL::BinaryCache::Stage> stages);
+
+    /// Compiles user shaders without stalling rendering.
+    OpenGL::AsyncCompiler m_compiler{main_window->handle()};
+
+    /// A program being compiled by m_compiler, to be installed into an ImportedProgram by update().
+    struct PendingProgram {
+        ImportedProgram* slot;
+        ImportedFile file;
+        OpenGL::AsyncCompiler::Ticket ticket;
+        std::string label;
+        /// Key in m_resident.
+        std::uint64_t resident_key;
+        /// Key in m_binaries.
+        std::uint64_t binary_key;
+        /// Files and line map of the translation unit, to locate errors.
+        FS::FileList files;
+        LineMap lines;
+    };
+
+    /// Programs being compiled, at most one per ImportedProgram.
+    std::vector<PendingProgram> m_pending;
+
+    /// @brief Compile an ImportedFile to be a single stage program of @p slot.
+    /// @details A resident variant or a cached binary is installed at once. Otherwise the program is compiled in the
+    /// background, replacing any other program being compiled for @p slot, and installed by update() when done.
+    /// Until then, or if anything fails, @p slot keeps its current program so that the output never goes blank.
+    void aux_compile(ImportedProgram& slot, const ImportedFile& file, OpenGL::ShaderStage stage, ShaderUsage usage);
+
+    /// Stop compiling the program of @p slot, if any.
+    void aux_cancel(const ImportedProgram& slot);
+
+    /// Make @p program that of @p slot, compiled from @p file.
+    void aux_install(ImportedProgram& slot, const ImportedFile& file, Shared<OpenGL::Program> program);
+
+    /// Keep values of uniforms @p old_program and @p new_program, which replaces it, agree on, and log what changed.
+    void aux_carry_over(const OpenGL::Program& old_program, const OpenGL::Program& new_program);
+
+    /// Contents of shader sources, invalidated as files are imported.
+    SourceFiles m_sources;
+
+    /// A shader preprocessed for some usage.
+    struct TranslationUnit {
+        /// Combined hash of defines and contents of files, see aux_translation_unit_key().
+        std::uint64_t key = 0;
+        PreprocessedSource preprocessed;
+    };
+
+    /// Last translation unit of each imported shader per usage, reused while its defines and files stay the same.
+    std::map<std::pair<FS::path, ShaderUsage>, TranslationUnit> m_translation_units;
+
+    /// @brief Preprocess @p file for @p usage with @p preprocessor, unless cached.
+    /// @return Expected pointer to the translation unit, valid until the next call. Unexpected message string if
+    /// preprocessing failed.
+    expected<const TranslationUnit*, std::string>
+    aux_preprocess(const FS::path& file, ShaderUsage usage, const Preprocessor& preprocessor);
+
+    /// @brief Combine @p defines_hash with content hashes of @p files.
+    /// @return The key, 0 if any of the files can't be read.
+    std::uint64_t aux_translation_unit_key(const FS::FileList& files, std::uint64_t defines_hash);
+
+    /// @brief Linked programs kept resident, keyed by hash of their preprocessed source combined with the shader type.
+    /// @details Bounded by the memory programs take, as told by their binary length. Identical sources, even
+    /// imported from different files or under different tags, share one program.
+    LRUCache<std::uint64_t, Shared<OpenGL::Program>> m_resident{options.opengl.resident_memory};
+
+    /// @brief Keys in m_resident of variants of shaders, keyed by their translation unit key combined with the shader
+    /// type.
+    /// @details A variant is compiled on first use; switching back to a resident one, e.g. by undefining a macro
+    /// just defined or toggling background off and on, costs neither preprocessing nor compilation.
+    LRUCache<std::uint64_t, std::uint64_t> m_variants{options.opengl.variants};
+
+    /// Keep @p program resident under @p key.
+    void aux_keep_resident(std::uint64_t key, const Shared<OpenGL::Program>& program);
+    /// Values of built-in uniforms of the current frame.
+    BuiltinBlock m_builtins{};
+    /// Block "Builtins" of every frame.
+    OpenGL::UniformRing m_builtin_ring{sizeof(BuiltinBlock)};
+
+    /// Compute m_builtins of the current frame, and write them to m_builtin_ring.
+    void aux_update_builtins();
+
+    /// Lights of the current frame, the first of which is assigned to loose uniforms "L" of programs not declaring
+    /// block "Lights".
+    std::vector<LightRecord> m_lights;
+    /// Block "Lights" of every frame.
+    OpenGL::StorageBuffer m_lights_buffer{sizeof(LightsHeader) + MaxLights * sizeof(LightRecord)};
+
+    /// Compute m_lights of the current frame, and write them to m_lights_buffer.
+    void aux_update_lights();
+
+    /// @brief Check blocks "Builtins", "Material" and "Lights" of @p program, if not yet, and bind those declared.
+    static void aux_check_blocks(const OpenGL::Program& program, BuiltinUniforms& uniforms);
+
+    /// @brief Assign a bunch of uniforms, useful for every shader, to @p program through @p uniforms.
+    /// @details Nothing to assign if @p program declares block "Builtins", which is bound already.
+    void aux_assign_uniforms(const OpenGL::Program& program, BuiltinUniforms& uniforms);
+
+    /// Subroutines selected for shaders of each stage.
+    std::array<OpenGL::SubroutineSelection, OpenGL::MaxShaderStage> m_subroutines{};
+
+    /// @brief Load subroutines selected for @p stage of the program of @p imported, if any.
+    /// @note Subroutines are forgotten as programs are bound; called after binding a pipeline using @p imported.
+    void aux_apply_subroutines(ImportedProgram& imported, OpenGL::ShaderStage stage);
 
     //region Forward rendering
 
     /// Program pipeline using stages of shader programs that were compiled from user specified shader sources.
-    /// @note Should always be validated before use. Only used in render().
+    /// @note Should always be validated before use, which is only done again when stages change.
+    /// Only used in render().
     OpenGL::ProgramPipeline m_pipeline_user;
 
     std::array<ImportedProgram, OpenGL::MaxShaderStage> m_programs_user{};
 
+    /// @brief All user stages linked into one non-separable program, letting the driver optimize across stages.
+    /// @details Used instead of m_pipeline_user if options.opengl.monolithic. Linked on demand from current sources
+    /// of the stages in m_programs_user by m_compiler, loaded from and stored into m_binaries, and kept in m_resident
+    /// so switching modes back and forth is free. Null until linked, while m_pipeline_user is drawn with instead.
+    Shared<OpenGL::Program> m_monolithic;
+    /// Whether any user stage changed since m_monolithic was linked.
+    bool m_monolithic_dirty = true;
+    /// Ticket of m_monolithic being linked by m_compiler, 0 if none; polled by update().
+    OpenGL::AsyncCompiler::Ticket m_monolithic_ticket = 0;
+    /// Keys of m_monolithic being linked, in m_resident and m_binaries.
+    std::uint64_t m_monolithic_resident_key = 0;
+    std::uint64_t m_monolithic_binary_key = 0;
+    /// Uniforms of m_monolithic.
+    BuiltinUniforms m_monolithic_uniforms;
+    /// Subroutines of each stage of m_monolithic.
+    std::array<OpenGL::SubroutineBinding, OpenGL::MaxShaderStage> m_monolithic_subroutines{};
+
+    /// @brief Start linking m_monolithic if any user stage changed, unless resident or cached.
+    /// @return Whether m_monolithic is ready.
+    bool aux_link_monolithic();
+
+    /// Render user meshes with either m_monolithic or m_pipeline_user.
+    void aux_render_user(bool monolithic);
+
+    /// Assign per-mesh uniforms of @p program through @p uniforms and draw user meshes with it.
+    void aux_draw_meshes(const OpenGL::Program& program, BuiltinUniforms& uniforms);
+
+    /// Materials imported with a mesh.
+    struct MeshMaterials {
+        std::vector<MaterialBlock> records;
+        /// Index of the first record in m_material_buffer.
+        GLint base = 0;
+    };
+    /// Materials of m_meshes, keyed alike.
+    std::unordered_map<ImportedFile, MeshMaterials> m_materials;
+    /// Whether m_materials changed since m_material_buffer was uploaded.
+    bool m_materials_dirty = true;
+    /// Records of all m_materials, the default material first, each aligned for binding.
+    OpenGL::Buffer m_material_buffer;
+    /// Size of a record in m_material_buffer, MaterialBlock rounded up to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT.
+    GLsizeiptr m_material_stride = sizeof(MaterialBlock);
+
+    /// Material of parts of meshes without any.
+    static const MaterialBlock DefaultMaterial;
+
+    /// Upload records of m_materials to m_material_buffer, if changed.
+    void aux_upload_materials();
+
     //endregion
 
     //region Debug rendering
@@ -95,8 +385,8 @@ class Sandbox {
     /// VAO for internal and static usage, like when drawing background or debug curves/planes.
     /// It specifies no vertex attributes at all and is the minimum VAO OpenGL can draw with.
     OpenGL::VertexArray m_vao_internal;
-    /// Program pipeline for internal usage, consisting of stages from pre-defined shader mostly.
-    OpenGL::ProgramPipeline m_pipeline_internal;
+    /// Program pipeline drawing m_debug_axes.
+    OpenGL::ProgramPipeline m_pipeline_debug;
 
     OpenGL::Program m_debug_axes; /// Debug drawing -- RGB unit axes located at world origin
     // OpenGL::Program m_debug_plane; /// Debug drawing -- x-z plane in gray grid
@@ -105,6 +395,8 @@ class Sandbox {
 
     //region Background rendering
 
+    /// Program pipeline of m_background_vert and m_background_frag.
+    OpenGL::ProgramPipeline m_pipeline_background;
     /// Vertex shader used to draw background (compiled from internal source)
     OpenGL::Program m_background_vert;
     /// Fragment shader used to draw background (compiled from user source)
@@ -115,11 +407,16 @@ class Sandbox {
 
     //region Postprocessing
 
+    /// Program pipeline of m_postprocess_vert and m_postprocess_frag.
+    OpenGL::ProgramPipeline m_pipeline_postprocess;
     /// Vertex shader used for postprocessing (compiled from internal source)
     OpenGL::Program m_postprocess_vert;
     /// Fragment shader used for postprocessing (compiled from user source)
     /// @note If non-empty, postprocessing is enabled.
     ImportedProgram m_postprocess_frag;
+    /// Texture units of inputs of m_postprocess_frag.
+    OpenGL::UniformHandle<GLint> m_u_scene{"u_scene"};
+    OpenGL::UniformHandle<GLint> m_u_depth{"u_depth"};
 
     OpenGL::Framebuffer m_scene; ///< FBO for postprocessing.
     OpenGL::Texture m_color_texture{Empty()}; ///< Input of postprocessing, attached to postprocessing FBO.
@@ -141,8 +438,23 @@ class Sandbox {
     std::unordered_map<ImportedFile, Shared<MeshBase>> m_meshes;
 
     bool aux_import_image(const ImportedFile& file);
+
+    /// @brief Import a file included by shaders, recompiling only the programs whose include closure contains it.
+    /// @param path The included file that changed.
+    /// @return True if successfully imported.
     bool aux_import_dependency(const ImportedFile& path);
 
+    /// '#include' relations among imported shaders and files they include.
+    IncludeGraph m_includes;
+
+    /// @brief Rescan includes of @p file and of files newly included, updating m_includes.
+    /// @details Files newly included are added to watch; files no longer included by anything are removed from watch.
+    void aux_update_includes(const FS::path& file, bool root);
+
+    /// @brief Recompile imported programs whose files satisfy @p pred.
+    template <typename Pred>
+    void aux_recompile(Pred&& pred);
+
     void aux_allocate_framebuffer_texture(glm::ivec2 fbsize);
 };
 
@@ -0,0 +1,42 @@
+/**
+ * @File Hash.hpp
+ * @brief Fast non-cryptographic hashing.
+ * @author Zhen Luo 461652354@qq.com
+ */
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+
+/// 64-bit hash of a byte sequence, using the XXH64 algorithm.
+/// @param data Address of the first byte.
+/// @param length Number of bytes.
+/// @param seed Seed of the hash; different seeds give unrelated hashes.
+/// @sa https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md
+std::uint64_t
+hash64(const void* data, std::size_t length, std::uint64_t seed = 0) noexcept;
+
+inline std::uint64_t
+hash64(const std::string& str, std::uint64_t seed = 0) noexcept
+{ return hash64(str.data(), str.size(), seed); }
+
+/// Combine a hash @p value into @p seed, order dependent.
+inline std::uint64_t
+hash_combine(std::uint64_t seed, std::uint64_t value) noexcept
+{ return seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6u) + (seed >> 2u)); }
+
+/// 64-bit FNV-1a hash of a short string such as an identifier, usable in constant expressions.
+/// @note Much slower than hash64() on long inputs; meant for names known at compile time.
+constexpr std::uint64_t
+hash_name(std::string_view name) noexcept
+{
+    std::uint64_t h = 0xcbf29ce484222325ull;
+    for (char c : name) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
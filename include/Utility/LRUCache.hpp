@@ -0,0 +1,115 @@
+/**
+ * @File LRUCache.hpp
+ * @brief Bounded cache evicting the least recently used entries.
+ * @author Zhen Luo 461652354@qq.com
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+
+/// Cache bounding the total cost of its entries, evicting the least recently used ones when over capacity.
+/// @details Each entry has a cost given on insertion, 1 by default so that capacity bounds the number of entries;
+/// costs may as well be sizes in bytes to bound memory. The most recently used entry is never evicted, even if it
+/// alone costs more than capacity (at least 1).
+/// Entries are kept in a list ordered by recency and indexed by a hash map, so that lookups, insertions and
+/// evictions are all O(1).
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class LRUCache {
+  public:
+    explicit LRUCache(std::size_t capacity) : m_capacity(std::max<std::size_t>(1, capacity))
+    {}
+
+    /// Look up @p key, marking it as most recently used if found.
+    /// @return Pointer to the value, null if not resident. Valid until the entry is evicted.
+    Value* find(const Key& key)
+    {
+        auto it = m_index.find(key);
+        if (it == m_index.end()) {
+            return nullptr;
+        }
+        m_entries.splice(m_entries.begin(), m_entries, it->second);
+        return &it->second->value;
+    }
+
+    /// Insert or replace the value of @p key, costing @p cost, as the most recently used, evicting the least
+    /// recently used entries beyond capacity.
+    Value& insert(const Key& key, Value value, std::size_t cost = 1)
+    {
+        if (find(key)) {
+            auto&& entry = m_entries.front();
+            m_cost = m_cost - entry.cost + cost;
+            entry.value = std::move(value);
+            entry.cost = cost;
+        } else {
+            m_entries.push_front({key, std::move(value), cost});
+            m_index.emplace(key, m_entries.begin());
+            m_cost += cost;
+        }
+        aux_shrink();
+        return m_entries.front().value;
+    }
+
+    void erase(const Key& key)
+    {
+        auto it = m_index.find(key);
+        if (it != m_index.end()) {
+            m_cost -= it->second->cost;
+            m_entries.erase(it->second);
+            m_index.erase(it);
+        }
+    }
+
+    void clear()
+    {
+        m_entries.clear();
+        m_index.clear();
+        m_cost = 0;
+    }
+
+    /// Number of entries.
+    std::size_t size() const
+    { return m_entries.size(); }
+
+    /// Total cost of entries.
+    std::size_t cost() const
+    { return m_cost; }
+
+    std::size_t capacity() const
+    { return m_capacity; }
+
+    /// Change capacity, i.e. maximum total cost, evicting the least recently used entries beyond it.
+    void set_capacity(std::size_t capacity)
+    {
+        m_capacity = std::max<std::size_t>(1, capacity);
+        aux_shrink();
+    }
+
+  private:
+    struct Entry {
+        Key key;
+        Value value;
+        std::size_t cost;
+    };
+
+    using Entries = std::list<Entry>;
+
+    std::size_t m_capacity;
+    std::size_t m_cost = 0;
+    /// Entries from the most recently used to the least.
+    Entries m_entries;
+    std::unordered_map<Key, typename Entries::iterator, Hash> m_index;
+
+    void aux_shrink()
+    {
+        while (m_cost > m_capacity && m_entries.size() > 1) {
+            m_cost -= m_entries.back().cost;
+            m_index.erase(m_entries.back().key);
+            m_entries.pop_back();
+        }
+    }
+};
@@ -0,0 +1,66 @@
+/**
+ * @File SPSCQueue.hpp
+ * @brief Bounded lock-free queue between exactly one producer and one consumer thread.
+ * @author Zhen Luo 461652354@qq.com
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+
+/// Bounded single-producer/single-consumer ring buffer.
+/// @details Slots are allocated once and reused: push() copy-assigns into a slot and pop() swaps a slot with the
+/// object given, so that types owning memory (strings, paths, ...) keep recycling their buffers instead of allocating.
+/// @tparam T Element type, must be default constructible, copy assignable and swappable.
+/// @tparam Capacity Number of slots, a power of 2.
+template <typename T, std::size_t Capacity>
+class SPSCQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of 2");
+
+  public:
+    /// Append a copy of @p value.
+    /// @note Only call from the producer thread.
+    /// @return False if the queue is full, in which case nothing happens.
+    bool push(const T& value)
+    {
+        auto tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) == Capacity) {
+            return false;
+        }
+        m_slots[tail & (Capacity - 1)] = value;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Take out the front element by swapping it into @p value.
+    /// @note Only call from the consumer thread.
+    /// @return False if the queue is empty, in which case @p value is left untouched.
+    bool pop(T& value)
+    {
+        auto head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        using std::swap;
+        swap(value, m_slots[head & (Capacity - 1)]);
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Whether the queue looks empty; exact only when called from the consumer thread.
+    bool empty() const
+    { return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire); }
+
+  private:
+    /// Keep indices on separate cache lines so that the two threads don't falsely share them.
+    static constexpr std::size_t CacheLine = 64;
+
+    std::array<T, Capacity> m_slots{};
+    /// Index of the next element to pop, only written by the consumer.
+    alignas(CacheLine) std::atomic<std::size_t> m_head{0};
+    /// Index of the next slot to push into, only written by the producer.
+    alignas(CacheLine) std::atomic<std::size_t> m_tail{0};
+};
@@ -0,0 +1,38 @@
+/**
+ * @File Validator.hpp
+ * @brief Batch validation of shader libraries without a display.
+ * @author Zhen Luo 461652354@qq.com
+ */
+#pragma once
+
+#include "FileSystem.hpp"
+#include "OpenGL/Common.hpp"
+#include <ostream>
+#include <string>
+
+
+/// Outcome of validating a single shader.
+struct ValidationResult {
+    FS::path file;
+    GLenum type = 0;
+    bool success = false;
+    /// Wall time spent preprocessing, in milliseconds.
+    double preprocess_ms = 0.0;
+    /// Wall time spent compiling, in milliseconds.
+    double compile_ms = 0.0;
+    /// Errors of preprocessing or compiling, located in the original files.
+    std::string log;
+};
+
+/// @brief Preprocess and compile every shader under @p directory, recognized by OpenGL::suffix_shader_type().
+/// @details Shaders are spread over @p jobs threads, each owning an OpenGL::HeadlessContext, so no display is needed.
+/// Macros in options.defines are defined and paths in options.includes searched, as when viewing.
+/// A report is printed to @p out in JSON Lines: one object per shader, ordered by path,
+/// @code{.json}
+/// {"file":"a.frag","stage":"fragment shader","status":"ok","preprocess_ms":0.08,"compile_ms":2.31,"log":""}
+/// @endcode
+/// followed by a summary object `{"summary":{"files":..,"failed":..,"jobs":..,"wall_ms":..}}`.
+/// @param jobs Number of threads; 0 for the number of hardware threads.
+/// @return EXIT_SUCCESS if every shader compiled, EXIT_FAILURE otherwise.
+int
+validate_shaders(const FS::path& directory, unsigned jobs, std::ostream& out);
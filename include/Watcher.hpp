@@ -6,10 +6,12 @@
 
 #include "Utility/Expected.hpp"
 #include "Utility/Thread.hpp"
+#include "Utility/SPSCQueue.hpp"
 #include "FileSystem.hpp"
 #include <unordered_map>
 #include <unordered_set>
 #include <set>
+#include <deque>
 
 
 enum class FileType : int {
@@ -24,16 +26,29 @@ struct ImportedFile {
     ImportedFile() = default;
     ImportedFile(const std::string& path, FileType type, std::string tag) noexcept;
 
-    ImportedFile(const ImportedFile& obj) : tag(obj.tag), m_path(obj.m_path), m_type(obj.m_type)
+    ImportedFile(const ImportedFile& obj) : tag(obj.tag), m_path(obj.m_path), m_type(obj.m_type),
+                                            m_last_modified(obj.m_last_modified), m_hash(obj.m_hash)
     {}
 
+    ImportedFile(ImportedFile&&) noexcept = default;
+
+    ImportedFile& operator=(const ImportedFile&) = default;
+
+    ImportedFile& operator=(ImportedFile&&) noexcept = default;
+
     const auto& path() const
     { return m_path; }
 
     auto type() const
     { return m_type; }
 
+    /// Hash of the file content when it was last checked.
+    auto hash() const
+    { return m_hash; }
+
     /// @brief Check for update and mark as modified if it is.
+    /// @details Only when modification time changes is the content read and hashed. A file whose content hashes the
+    /// same as before is not considered updated, e.g. when it's merely touched.
     bool check_update() const;
 
     bool operator<(const ImportedFile& rhs) const
@@ -65,6 +80,8 @@ struct ImportedFile {
     FileType m_type{FileType::None};
     /// Time point when the file was last modified.
     mutable FS::ModifiedTimePoint m_last_modified{};
+    /// Hash of file content when last checked.
+    mutable std::uint64_t m_hash{0};
 };
 
 namespace std {
@@ -82,6 +99,10 @@ struct hash<ImportedFile> {
 }
 
 /// Thread watching a set of files
+/// @details On Linux the thread blocks on inotify, watching parent directories of the files so that editors saving
+/// through write-temp-then-rename are caught as well. Elsewhere, or if inotify is unavailable, it falls back to
+/// polling modification time of every file.
+/// Whole directory trees can be watched with glob patterns, shaders showing up in them being imported automatically.
 class Watcher {
   public:
     explicit Watcher(const std::vector<ImportedFile>& to_watch);
@@ -92,26 +113,99 @@ class Watcher {
 
     void unwatch(const FS::path& path, const std::string& tag);
 
+    /// Watch a directory tree for shaders matching a glob pattern.
+    /// @details Files created or modified in the tree that match @p glob and have a known shader suffix are imported
+    /// with @p tag, i.e. reported as updated and watched from then on.
+    /// @param glob Glob pattern such as "shaders/**/*.frag", see FS::glob_match.
+    /// @param tag Tag given to imported files.
+    void watch_tree(const std::string& glob, const std::string& tag);
+
     expected<ImportedFile, std::string> find(const FS::path& path, const std::string& tag);
 
-    /// Move out the set of currently updated files.
-    /// @warning Don't ignore its return value unless you really mean to.
-    std::unordered_set<ImportedFile> updated()
-    {
-        std::lock_guard guard(mutex_updated);
-        return std::move(m_updated);
-    }
+    /// Take out the next updated file, without locking or allocating.
+    /// @param file Receives the file; reuse the same object across calls so that its buffers are recycled.
+    /// @return False if there is no more updated file, in which case @p file is left untouched.
+    /// @note Only call from one thread, e.g. the main loop.
+    bool pop_updated(ImportedFile& file)
+    { return m_updated.pop(file); }
 
     std::set<std::pair<FS::path, std::string>> files() const;
 
   private:
+    using Clock = std::chrono::steady_clock;
+
+    /// Interval between two polls of the fallback backend, in milliseconds.
+    static constexpr float PollInterval = 250.0f;
+
+    /// A directory tree watched for files matching a pattern.
+    struct Tree {
+        /// Canonical path to the root directory of the tree.
+        FS::path root;
+        /// Glob pattern relative to root.
+        FS::path pattern;
+        /// Tag given to files imported from the tree.
+        std::string tag;
+        /// Files ever seen in the tree, only maintained when polling.
+        std::unordered_set<FS::path> known;
+    };
+
     std::unordered_map<std::pair<FS::path, std::string>, ImportedFile> m_watching_files;
+    /// Every tag of files watched, so that files can be looked up by path alone.
+    std::set<std::string> m_tags;
+    std::vector<Tree> m_trees;
     mutable std::mutex mutex_watching_files;
-    std::unordered_set<ImportedFile> m_updated;
-    std::mutex mutex_updated;
+    /// Updated files, handed from the watching thread to the consumer of pop_updated().
+    SPSCQueue<ImportedFile, 256> m_updated;
+    /// Updated files that didn't fit into m_updated, only touched by the watching thread.
+    std::deque<ImportedFile> m_overflow;
+
+    /// eventfd used to wake the watching thread up when destructing; -1 if polling instead.
+    int m_wakeup = -1;
+    /// inotify instance; -1 if polling instead.
+    int m_inotify = aux_init_inotify(); // XXX MUST be initialized after m_wakeup, which it also initializes.
+    /// Watch descriptor -> watched directory.
+    std::unordered_map<int, FS::path> m_directories;
 
     std::atomic_bool m_watching = true;
     std::thread m_thread; // XXX MUST be initialized after mutexes and atomics it might uses.
+
+    /// Create the inotify instance and m_wakeup if supported.
+    /// @return The inotify file descriptor, -1 if unsupported.
+    int aux_init_inotify();
+    /// Start watching @p directory if not yet.
+    /// @note mutex_watching_files must be held.
+    void aux_watch_directory(const FS::path& directory);
+    /// Start watching @p directory and all its subdirectories.
+    /// @details Directories are walked with readdir, which tells directories apart without stat'ing every file.
+    /// @param found If not null, receives every non-directory file in the tree.
+    /// @note mutex_watching_files must be held.
+    void aux_watch_tree(const FS::path& directory, FS::FileList* found);
+    /// Whether @p path is inside tree @p tree and matches its pattern.
+    static bool aux_match(const Tree& tree, const FS::path& path);
+    /// Handle a file whose events have settled, checking it if watched and importing it if in a watched tree.
+    /// @note mutex_watching_files must be held.
+    void aux_settled(const FS::path& path);
+    /// Import a shader found in a watched tree, marking it as updated.
+    /// @note mutex_watching_files must be held.
+    void aux_import(const FS::path& path, const std::string& tag);
+    /// Hand an updated file to the consumer, or keep it in m_overflow if the queue is full.
+    /// @note Only call from the watching thread.
+    void aux_push(const ImportedFile& file);
+    /// Move as many files from m_overflow into m_updated as fit.
+    /// @note Only call from the watching thread.
+    void aux_flush();
+    /// Drop @p tag from m_tags unless a file is still watched with it.
+    /// @note mutex_watching_files must be held.
+    void aux_forget_tag(const std::string& tag);
+    /// Check a file for update, marking it as updated if so.
+    /// @note mutex_watching_files must be held.
+    void aux_check(const ImportedFile& file);
+    /// Block on inotify until the watcher is destructed.
+    /// @details Events on a file are coalesced: it's only checked once no more events arrive on it within
+    /// options.watch.settle milliseconds.
+    void aux_loop_inotify();
+    /// Poll every watched file and scan every watched tree until the watcher is destructed.
+    void aux_loop_polling();
 };
 
 
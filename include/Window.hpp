@@ -64,6 +64,9 @@ class Window {
     double frame_delay()
     { return m_properties.frame_delay; }
 
+    Handle handle() const
+    { return m_handle; }
+
     static Window* find_by_handle(Handle handle);
 
     struct Callbacks {
@@ -22,13 +22,13 @@ struct light_t {
 
 uniform light_t L;
 
-struct material_t {
+// material of the part of mesh being drawn
+layout(std140, binding = 1) uniform Material {
     vec3 ka;
+    float shininess;
     vec3 kd;
     vec3 ks;
-    float shininess;
-};
-uniform material_t M;
+} M;
 
 uniform mat4 PV;
 uniform mat4 VM;
@@ -182,6 +182,15 @@ declare_commands()
                                  sandbox->recompile_all();
                              }
                          });
+    Console::add_command("undefine", {1, -1u}, {"macro=value"},
+                         "Undefine macros exactly as they were defined. (Seen by shader preprocessor)",
+                         [](std::string cmd, Arguments args)
+                         {
+                             for (auto&& arg : args) {
+                                 options.undefine(arg);
+                             }
+                             sandbox->recompile_all();
+                         });
     Console::add_command("mouse", {0, 0}, {},
                          "Display current mouse position",
                          [](std::string cmd, Arguments)
@@ -199,6 +208,10 @@ declare_commands()
                                  *console << "\tPath:" << path << '[' << tag << "]\n";
                              }
                          });
+    Console::add_command("watch", {1, 1}, {"glob"},
+                         "Watch a directory tree for shaders matching a glob pattern, importing them once created or modified.",
+                         [](std::string cmd, Arguments args)
+                         { sandbox->watcher.watch_tree(args.front(), "user"); });
     Console::add_command("programs", {0, 0}, {},
                          "Display current imported shader programs by their OpenGL object names and optional labels.",
                          [](std::string cmd, Arguments args)
@@ -208,7 +221,8 @@ declare_commands()
                                  *console << "\tProgram" << name << ':' << label << '\n';
                              }
                          });
-    Console::add_command("program", {1, 2}, {"name", "interface name:uniform|uniform_block|input"},
+    Console::add_command("program", {1, 2},
+                         {"name", "interface name:uniform|uniform_block|buffer_variable|shader_storage_block|input"},
                          "Introspect specified program and optionally in the specified interface.",
             // TODO built-in introspection might not be worth it, NVIDIA Nsight has done a great job.
                          [](std::string cmd, Arguments args)
@@ -224,6 +238,10 @@ declare_commands()
                                      *console << intro->uniform() << '\n';
                                  } else if (args.back() == "uniform_block") {
                                      *console << intro->uniform_block() << '\n';
+                                 } else if (args.back() == "buffer_variable") {
+                                     *console << intro->buffer_variable() << '\n';
+                                 } else if (args.back() == "shader_storage_block") {
+                                     *console << intro->shader_storage_block() << '\n';
                                  } else if (args.back() == "input") {
                                      *console << intro->input() << '\n';
                                  } else {
@@ -259,6 +277,98 @@ declare_commands()
                                  sandbox->import(file, true);
                              }
                          });
+    Console::add_command("link", {0, 1}, {"separable|monolithic"},
+                         "Display how user shaders are linked or change it.",
+                         [](std::string cmd, Arguments args)
+                         {
+                             if (args.empty()) {
+                                 *console << (options.opengl.monolithic ? "monolithic" : "separable") << '\n';
+                             } else if (args.front() == "separable") {
+                                 options.opengl.monolithic = false;
+                             } else if (args.front() == "monolithic") {
+                                 options.opengl.monolithic = true;
+                             } else {
+                                 Log::i("{}: Unknown argument: {}", cmd, args.front());
+                             }
+                         });
+    Console::add_command("benchmark", {0, 1}, {"frames"},
+                         "Time rendering user meshes with separable and monolithic programs on the GPU.",
+                         [](std::string cmd, Arguments args)
+                         {
+                             unsigned frames = args.empty() ? 100u : string_to<unsigned>(args.front());
+                             for (auto&& timing : sandbox->benchmark(frames)) {
+                                 *console << fmt::format("{:<10} {} frames: min {:.3f}ms median {:.3f}ms mean {:.3f}ms",
+                                                         timing.mode, timing.frames, timing.min_ms,
+                                                         timing.median_ms, timing.mean_ms) << '\n';
+                             }
+                         });
+    Console::add_command("uploads", {0, 1}, {"reset"},
+                         "Display numbers of uniform uploads issued and skipped as redundant, or reset them.",
+                         [](std::string cmd, Arguments args)
+                         {
+                             auto&& uploads = OpenGL::details::UniformShadow::Uploads();
+                             if (args.empty()) {
+                                 *console << fmt::format("Uniform uploads: {} issued, {} skipped", uploads.issued,
+                                                         uploads.skipped) << '\n';
+                             } else if (args.front() == "reset") {
+                                 uploads = {};
+                             } else {
+                                 Log::i("{}: Unknown argument: {}", cmd, args.front());
+                             }
+                         });
+    Console::add_command("subroutine", {0, 3}, {"stage:vert|tesc|tese|geom|frag|comp", "uniform", "subroutine|reset"},
+                         "Display subroutine uniforms and the subroutines they take, optionally of a stage, or select "
+                         "a subroutine for a subroutine uniform of a stage; 'reset' drops the selection.",
+                         [](std::string cmd, Arguments args)
+                         {
+                             using Stage = OpenGL::ShaderStage;
+                             std::vector<Stage> stages;
+                             if (args.empty()) {
+                                 for (std::size_t i = 0; i < OpenGL::MaxShaderStage; ++i) {
+                                     stages.push_back(static_cast<Stage>(i));
+                                 }
+                             } else if (auto&& type = OpenGL::suffix_shader_type('.' + args.front())) {
+                                 stages.push_back(OpenGL::shader_type_stage(*type));
+                             } else {
+                                 Log::i("{}: Unknown stage: {}", cmd, args.front());
+                                 return;
+                             }
+                             auto stage = stages.front();
+                             if (args.size() == 2) {
+                                 Log::i("{}: Missing subroutine for {}", cmd, args.back());
+                             } else if (args.size() == 3 && args.back() == "reset") {
+                                 sandbox->deselect_subroutine(stage, *std::next(args.begin()));
+                             } else if (args.size() == 3) {
+                                 auto&& selected = sandbox->select_subroutine(stage, *std::next(args.begin()),
+                                                                              args.back());
+                                 if (!selected) {
+                                     Log::w("{}: {}", cmd, selected.error());
+                                 }
+                             }
+                             if (args.size() > 1) {
+                                 return;
+                             }
+                             for (auto s : stages) {
+                                 auto&& selection = sandbox->subroutines(s);
+                                 for (auto&& program : sandbox->stage_programs(s)) {
+                                     auto&& introspector = program->interfaces().lock();
+                                     OpenGL::visit_subroutine_uniforms(*introspector, s, [&](auto&& interface)
+                                     {
+                                         for (auto&& uniform : interface.resources) {
+                                             auto* taken = selection.subroutine(uniform);
+                                             *console << "\tProgram" << program->name() << ':' << program->label()
+                                                      << ' ' << uniform.name << ':';
+                                             for (auto&& subroutine : uniform.subroutines) {
+                                                 bool is_taken = &subroutine == taken;
+                                                 *console << ' ' << (is_taken ? "[" : "") << subroutine.name
+                                                          << (is_taken ? "]" : "");
+                                             }
+                                             *console << '\n';
+                                         }
+                                     });
+                                 }
+                             }
+                         });
     // Console::add_command("command", {0, 0}, {},
     //                      "description",
     //                      [](std::string cmd, Arguments args)
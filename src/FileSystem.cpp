@@ -8,18 +8,94 @@
 #include <Options.hpp>
 
 #include <fstream>
+#include <algorithm>
 
 
 namespace FS {
 
 namespace {
 
-/// Resolve the canonical path of a relative path.
-/// @param relative_path The path relative to the @p base_path.
-/// @param base_path The base directory.
-/// @details When determining the actual base path, @p base_path is considered first of all.
-/// Only if not found under @p base_path will folders in @p include_folders be tried one by one.
-/// @returns The canonical path if resolved successfully. Otherwise empty path.
+bool
+is_wildcard(const std::string& component)
+{ return component.find_first_of("*?") != std::string::npos; }
+
+/// Match a single path component against a pattern component consisting of '*', '?' and literals.
+bool
+match_component(const std::string& pattern, const std::string& str)
+{
+    size_t p = 0, s = 0;
+    size_t star = std::string::npos, retry = 0;
+    while (s < str.size()) {
+        if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == str[s])) {
+            ++p;
+            ++s;
+        } else if (p < pattern.size() && pattern[p] == '*') {
+            star = p++;
+            retry = s;
+        } else if (star != std::string::npos) {
+            p = star + 1;
+            s = ++retry;
+        } else {
+            return false;
+        }
+    }
+    while (p < pattern.size() && pattern[p] == '*') {
+        ++p;
+    }
+    return p == pattern.size();
+}
+
+template <typename It>
+bool
+match_components(It pattern, It pattern_end, It path, It path_end)
+{
+    while (pattern != pattern_end) {
+        if (pattern->string() == "**") {
+            for (auto it = path;; ++it) {
+                if (match_components(std::next(pattern), pattern_end, it, path_end)) {
+                    return true;
+                }
+                if (it == path_end) {
+                    return false;
+                }
+            }
+        }
+        if (path == path_end || !match_component(pattern->string(), path->string())) {
+            return false;
+        }
+        ++pattern;
+        ++path;
+    }
+    return path == path_end;
+}
+
+} // namespace
+
+std::pair<FS::path, FS::path>
+glob_split(const std::string& glob)
+{
+    FS::path pattern(glob);
+    FS::path root, rest;
+    bool wild = false;
+    for (auto&& component : pattern) {
+        wild = wild || is_wildcard(component.string());
+        (wild ? rest : root) /= component;
+    }
+    if (!wild) {
+        // a plain path; watch its directory for exactly that file
+        rest = root.filename();
+        root = root.parent_path();
+    }
+    if (root.empty()) {
+        root = ".";
+    }
+    return {root, rest};
+}
+
+bool
+glob_match(const FS::path& pattern, const FS::path& path)
+{ return match_components(pattern.begin(), pattern.end(), path.begin(), path.end()); }
+
 std::string
 resolve_url(const FS::path& base_path, const FS::path& relative_path)
 {
@@ -37,74 +113,4 @@ resolve_url(const FS::path& base_path, const FS::path& relative_path)
     return {};
 }
 
-/// Extract dependency from "#include <file>" or "#pragma include <file>".
-/// @param line A single line of GLSL source code.
-/// @return The relative path to the file included. Empty if @p line does not "include" anything.
-/// @details This function does not check if the file exists or even is a valid path.
-FS::path
-extract_include(const std::string& line)
-{
-    auto contains = [](const std::string& str, const std::string& substr)
-    { return str.find(substr) != std::string::npos; };
-    if (contains(line, "#include ") || contains(line, "#pragma include")) {
-        auto begin = line.find_first_of('"') + 1;
-        auto len = line.find_last_of('"') - begin;
-        FS::path ret = line.substr(begin, len);
-        return ret;
-    }
-    return {};
-}
-
-} // namespace
-
-// bool
-// load_shader(const FS::path& file_name, std::string& into, FS::FileList& dependencies)
-// {
-//     std::ifstream file;
-//     file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-//     try {
-//         file.open(file_name);
-//     } catch (std::ifstream::failure& e) {
-//         Log::e("Failed to open file {}: {}", file_name, e.what());
-//         return false;
-//     }
-//     file.exceptions(std::ifstream::badbit);
-//     // parse for dependencies line by line.
-//     const auto&& base_path = file_name.parent_path();
-//     if (std::find(dependencies.begin(), dependencies.end(), file_name) != dependencies.end()) {
-//         Log::w("{} is already included! Cyclic include is skipped.", file_name);
-//         return true;
-//     }
-//     dependencies.push_back(file_name);
-//     std::string line;
-//     while (getline(file, line)) {
-//         auto&& include_file = extract_include(line);
-//         if (include_file.empty()) {
-//             // normal line, just append
-//             into += line + '\n';
-//         } else {
-//             // #include line, try to insert the content of the included file right here
-//             auto&& dependency = resolve_url(base_path, include_file);
-//             if (dependency.empty()) {
-//                 Log::e("Can not resolve file: {}\nincluded by: {}", include_file, file_name);
-//                 return false;
-//             }
-//             if (!load_shader(dependency, into, dependencies)) {
-//                 // failed to load; log error
-//                 std::string folders;
-//                 for (const auto& folder : options.includes) {
-//                     folders += "\n\t";
-//                     folders += folder;
-//                 }
-//                 if (folders.empty()) {
-//                     folders = "\n\t<none>";
-//                 }
-//                 Log::e("Failed to load {}\nAddtional include folders:{}", dependency, folders);
-//                 return false;
-//             }
-//         }
-//     }
-//     return true;
-// }
-
 } // namespace FS
@@ -0,0 +1,109 @@
+/**
+ * @File IncludeGraph.cpp
+ * @author Zhen Luo 461652354@qq.com
+ */
+#include <IncludeGraph.hpp>
+#include <algorithm>
+
+
+IncludeGraph::Changes
+IncludeGraph::update(const FS::path& file, const FS::FileList& includes, bool root)
+{
+    Changes changes;
+    auto&&[it, inserted] = m_nodes.try_emplace(file);
+    if (inserted) {
+        changes.added.push_back(file);
+    }
+    it->second.root |= root;
+    FS::FileList old_includes = std::move(it->second.includes);
+    it->second.includes = includes;
+    for (auto&& included : includes) {
+        auto&&[node, new_node] = m_nodes.try_emplace(included);
+        if (new_node) {
+            changes.added.push_back(included);
+        }
+        node->second.included_by.insert(file);
+    }
+    for (auto&& included : old_includes) {
+        if (std::find(includes.begin(), includes.end(), included) != includes.end()) {
+            continue;
+        }
+        auto node = m_nodes.find(included);
+        if (node != m_nodes.end()) {
+            node->second.included_by.erase(file);
+            aux_prune(included, changes);
+        }
+    }
+    return changes;
+}
+
+IncludeGraph::Changes
+IncludeGraph::remove_root(const FS::path& file)
+{
+    Changes changes;
+    auto it = m_nodes.find(file);
+    if (it != m_nodes.end()) {
+        it->second.root = false;
+        aux_prune(file, changes);
+    }
+    return changes;
+}
+
+IncludeGraph::FileSet
+IncludeGraph::dependents(const FS::path& file) const
+{ return aux_traverse(file, [](const Node& node) -> auto& { return node.included_by; }); }
+
+IncludeGraph::FileSet
+IncludeGraph::closure(const FS::path& file) const
+{ return aux_traverse(file, [](const Node& node) -> auto& { return node.includes; }); }
+
+void
+IncludeGraph::aux_prune(const FS::path& file, Changes& changes)
+{
+    // only files @p file reaches may have lost their last path from a root; counting incoming edges instead would
+    // keep files including each other forever
+    FS::FileList unreachable;
+    for (auto&& candidate : closure(file)) {
+        if (!contains(candidate)) {
+            continue;
+        }
+        auto&& reaching = dependents(candidate);
+        if (std::none_of(reaching.begin(), reaching.end(), [this](const FS::path& path)
+        { return m_nodes.at(path).root; })) {
+            unreachable.push_back(candidate);
+        }
+    }
+    for (auto&& path : unreachable) {
+        auto it = m_nodes.find(path);
+        for (auto&& included : it->second.includes) {
+            auto node = m_nodes.find(included);
+            if (node != m_nodes.end()) {
+                node->second.included_by.erase(path);
+            }
+        }
+        m_nodes.erase(it);
+        changes.removed.push_back(path);
+    }
+}
+
+template <typename Edges>
+IncludeGraph::FileSet
+IncludeGraph::aux_traverse(const FS::path& file, Edges edges) const
+{
+    FileSet visited{file};
+    FS::FileList stack{file};
+    while (!stack.empty()) {
+        auto current = std::move(stack.back());
+        stack.pop_back();
+        auto it = m_nodes.find(current);
+        if (it == m_nodes.end()) {
+            continue;
+        }
+        for (auto&& next : edges(it->second)) {
+            if (visited.insert(next).second) {
+                stack.push_back(next);
+            }
+        }
+    }
+    return visited;
+}
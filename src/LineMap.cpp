@@ -0,0 +1,108 @@
+/**
+ * @File LineMap.cpp
+ * @author Zhen Luo 461652354@qq.com
+ */
+#include <LineMap.hpp>
+#include <algorithm>
+#include <cctype>
+
+
+namespace {
+
+/// Parse a decimal number at @p it, moving @p it past it.
+/// @return False if there is no digit at @p it.
+bool
+parse_number(const std::string& str, std::size_t& it, std::size_t& value)
+{
+    auto begin = it;
+    value = 0;
+    while (it < str.size() && std::isdigit(static_cast<unsigned char>(str[it]))) {
+        value = value * 10 + static_cast<std::size_t>(str[it++] - '0');
+    }
+    return it != begin;
+}
+
+bool
+starts_with(const std::string& str, std::size_t pos, const char* prefix)
+{ return str.compare(pos, std::char_traits<char>::length(prefix), prefix) == 0; }
+
+} // namespace
+
+void
+LineMap::add(std::size_t expanded, FileIndex file, std::size_t line)
+{
+    if (!m_intervals.empty() && m_intervals.back().expanded == expanded) {
+        m_intervals.pop_back(); // the last interval turned out empty
+    }
+    if (!m_intervals.empty()) {
+        auto&& last = m_intervals.back();
+        if (last.file == file && last.line + (expanded - last.expanded) == line) {
+            return; // continues the last interval
+        }
+    }
+    m_intervals.push_back({static_cast<std::uint32_t>(expanded), file, static_cast<std::uint32_t>(line)});
+}
+
+void
+LineMap::prepend_generated(std::size_t count)
+{
+    if (count == 0) {
+        return;
+    }
+    for (auto&& interval : m_intervals) {
+        interval.expanded += static_cast<std::uint32_t>(count);
+    }
+    m_intervals.insert(m_intervals.begin(), {1, Generated, 1});
+}
+
+LineMap::Location
+LineMap::locate(std::size_t expanded) const
+{
+    auto it = std::upper_bound(m_intervals.begin(), m_intervals.end(), expanded,
+                               [](std::size_t line, const Interval& interval) { return line < interval.expanded; });
+    if (it == m_intervals.begin()) {
+        return {Generated, expanded};
+    }
+    --it;
+    return {it->file, it->line + (expanded - it->expanded)};
+}
+
+std::string
+LineMap::rewrite(const std::string& log, const FS::FileList& files) const
+{
+    std::string ret;
+    ret.reserve(log.size() + log.size() / 2);
+    for (std::size_t begin = 0; begin < log.size();) {
+        auto end = log.find('\n', begin);
+        end = end == std::string::npos ? log.size() : end + 1;
+        auto it = begin;
+        for (auto&& prefix : {"ERROR: ", "WARNING: "}) {
+            if (starts_with(log, it, prefix)) {
+                it += std::char_traits<char>::length(prefix);
+                break;
+            }
+        }
+        auto location_begin = it;
+        std::size_t string_number, line;
+        bool matched = parse_number(log, it, string_number) && it < end;
+        if (matched && log[it] == '(') {
+            matched = parse_number(log, ++it, line) && it < end && log[it++] == ')';
+        } else if (matched && log[it] == ':') {
+            matched = parse_number(log, ++it, line);
+        } else {
+            matched = false;
+        }
+        if (!matched || string_number != 0) {
+            ret.append(log, begin, end - begin);
+        } else {
+            auto&& location = locate(line);
+            ret.append(log, begin, location_begin - begin);
+            ret += location.file < files.size() ? files[location.file].string() : "<generated>";
+            ret += ':';
+            ret += std::to_string(location.line);
+            ret.append(log, it, end - it);
+        }
+        begin = end;
+    }
+    return ret;
+}
@@ -0,0 +1,185 @@
+/**
+ * @File AsyncCompiler.cpp
+ * @author Zhen Luo 461652354@qq.com
+ */
+#include <OpenGL/AsyncCompiler.hpp>
+#include <Options.hpp>
+#include <Utility/Log.hpp>
+
+
+namespace OpenGL {
+
+AsyncCompiler::AsyncCompiler(GLFWwindow* share)
+        : m_parallel(GLAD_GL_KHR_parallel_shader_compile || GLAD_GL_ARB_parallel_shader_compile)
+{
+    if (m_parallel) {
+        // let the driver decide how many threads to use
+        if (GLAD_GL_KHR_parallel_shader_compile) {
+            glMaxShaderCompilerThreadsKHR(0xFFFFFFFFu);
+        } else {
+            glMaxShaderCompilerThreadsARB(0xFFFFFFFFu);
+        }
+        Log::i("Compiling shaders with parallel_shader_compile");
+        return;
+    }
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    m_context = glfwCreateWindow(1, 1, "", nullptr, share);
+    glfwWindowHint(GLFW_VISIBLE, options.window.hidden ? GLFW_FALSE : GLFW_TRUE);
+    if (!m_context) {
+        Log::w("Failed to create a shared context; compiling shaders synchronously");
+        return;
+    }
+    m_worker = std::thread([this]() { aux_work(); });
+    Log::i("Compiling shaders on a worker thread");
+}
+
+AsyncCompiler::~AsyncCompiler()
+{
+    if (m_worker.joinable()) {
+        {
+            std::lock_guard guard(mutex_jobs);
+            m_stop = true;
+        }
+        m_jobs_changed.notify_one();
+        m_worker.join();
+        for (auto&&[ticket, name] : m_done) {
+            m_discarded.push_back(name);
+        }
+        aux_delete(m_discarded);
+    }
+    if (m_context) {
+        glfwDestroyWindow(m_context);
+    }
+}
+
+AsyncCompiler::Ticket
+AsyncCompiler::compile(GLenum type, std::string source)
+{
+    std::vector<Stage> stages;
+    stages.emplace_back(type, std::move(source));
+    return aux_submit({0, std::move(stages), true});
+}
+
+AsyncCompiler::Ticket
+AsyncCompiler::link(std::vector<Stage> stages)
+{ return aux_submit({0, std::move(stages), false}); }
+
+AsyncCompiler::Ticket
+AsyncCompiler::aux_submit(Job job)
+{
+    auto ticket = job.ticket = m_next_ticket++;
+    if (m_parallel || !m_worker.joinable()) {
+        // returns at once if the driver compiles in parallel, otherwise there is nothing better to do
+        m_programs.emplace(ticket, aux_create(job));
+    } else {
+        {
+            std::lock_guard guard(mutex_jobs);
+            aux_delete(m_discarded);
+            m_discarded.clear();
+            m_jobs.push_back(std::move(job));
+        }
+        m_jobs_changed.notify_one();
+    }
+    return ticket;
+}
+
+Program
+AsyncCompiler::aux_create(const Job& job)
+{
+    if (job.separable) {
+        auto&&[type, source] = job.stages.front();
+        return Program(type, {source}, Program::Deferred());
+    }
+    Program program;
+    for (auto&&[type, source] : job.stages) {
+        Shader shader(type); // flagged for deletion, deleted with the program it's attached to
+        shader.source(source);
+        glCompileShader(shader.name()); // not Shader::compile(), which waits for the status
+        program.attach(shader);
+    }
+    return std::move(program.link(Program::Deferred()));
+}
+
+Shared<Program>
+AsyncCompiler::poll(Ticket ticket)
+{
+    auto it = m_programs.find(ticket);
+    if (it == m_programs.end()) {
+        std::lock_guard guard(mutex_jobs);
+        auto done = m_done.find(ticket);
+        if (done == m_done.end()) {
+            return nullptr;
+        }
+        it = m_programs.emplace(ticket, Program(done->second, Program::Adopt())).first;
+        m_done.erase(done);
+    }
+    if (!it->second.completed()) {
+        return nullptr;
+    }
+    auto program = std::make_shared<Program>(std::move(it->second.check()));
+    m_programs.erase(it);
+    return program;
+}
+
+void
+AsyncCompiler::cancel(Ticket ticket)
+{
+    m_programs.erase(ticket);
+    std::lock_guard guard(mutex_jobs);
+    auto done = m_done.find(ticket);
+    if (done != m_done.end()) {
+        Program discarded(done->second, Program::Adopt()); // deleted as it goes out of scope
+        m_done.erase(done);
+        return;
+    }
+    if (m_working == ticket) {
+        m_working = 0; // let the worker discard it
+        return;
+    }
+    for (auto it = m_jobs.begin(); it != m_jobs.end(); ++it) {
+        if (it->ticket == ticket) {
+            m_jobs.erase(it);
+            break;
+        }
+    }
+}
+
+void
+AsyncCompiler::aux_work()
+{
+    glfwMakeContextCurrent(m_context);
+    while (true) {
+        Job job;
+        {
+            std::unique_lock lock(mutex_jobs);
+            m_jobs_changed.wait(lock, [this]() { return m_stop || !m_jobs.empty(); });
+            if (m_stop) {
+                break;
+            }
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+            m_working = job.ticket;
+        }
+        // the name is released at once, so the empty program left behind is destroyed without a trace
+        GLuint program = aux_create(job).release();
+        glFinish(); // the program must be complete before the rendering context sees it
+        std::lock_guard guard(mutex_jobs);
+        if (m_working == job.ticket) {
+            m_done.emplace(job.ticket, program);
+        } else {
+            m_discarded.push_back(program);
+        }
+        m_working = 0;
+    }
+    glfwMakeContextCurrent(nullptr); // programs left in m_done are deleted by the rendering thread
+}
+
+void
+AsyncCompiler::aux_delete(const std::vector<GLuint>& names)
+{
+    for (auto name : names) {
+        Program discarded(name, Program::Adopt());
+    }
+}
+
+} // namespace OpenGL
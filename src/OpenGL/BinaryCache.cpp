@@ -0,0 +1,190 @@
+/**
+ * @File BinaryCache.cpp
+ * @author Zhen Luo 461652354@qq.com
+ */
+#include <OpenGL/BinaryCache.hpp>
+#include <Utility/Hash.hpp>
+#include <Utility/Log.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <random>
+
+
+namespace OpenGL {
+
+namespace {
+
+/// Header of a binary file.
+struct Header {
+    char magic[4] = {'G', 'S', 'P', 'B'};
+    std::uint32_t version = 1;
+    std::uint64_t key = 0;
+    GLenum format = 0;
+    std::uint32_t length = 0;
+};
+
+bool
+operator==(const Header& lhs, const Header& rhs)
+{
+    return std::equal(std::begin(lhs.magic), std::end(lhs.magic), std::begin(rhs.magic)) &&
+           lhs.version == rhs.version && lhs.key == rhs.key;
+}
+
+std::uint64_t
+hash_string(GLenum name, std::uint64_t seed)
+{
+    auto* str = reinterpret_cast<const char*>(glGetString(name));
+    return str ? hash64(str, std::strlen(str), seed) : seed;
+}
+
+} // namespace
+
+BinaryCache::BinaryCache(FS::path directory) : m_directory(std::move(directory))
+{
+    if (!enabled()) {
+        return;
+    }
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    if (formats <= 0) {
+        Log::w("No program binary format supported; program binary cache disabled");
+        m_directory.clear();
+        return;
+    }
+    std::error_code ec;
+    FS::details::create_directories(m_directory, ec);
+    if (ec) {
+        Log::w("Failed to create program binary cache directory {}: {}", m_directory, ec.message());
+        m_directory.clear();
+        return;
+    }
+    for (auto name : {GL_VENDOR, GL_RENDERER, GL_VERSION, GL_SHADING_LANGUAGE_VERSION}) {
+        m_implementation = hash_string(name, m_implementation);
+    }
+    Log::i("Caching program binaries in {}", m_directory);
+}
+
+std::uint64_t
+BinaryCache::key(const std::vector<Stage>& stages, bool separable) const
+{
+    auto key = m_implementation;
+    for (auto&&[type, source] : stages) {
+        key = hash_combine(key, type);
+        key = hash_combine(key, hash64(*source));
+    }
+    return separable ? hash_combine(key, GL_PROGRAM_SEPARABLE) : key;
+}
+
+Program
+BinaryCache::load(std::uint64_t key, bool separable) const
+{
+    if (!enabled()) {
+        return Empty();
+    }
+    std::ifstream file(aux_path(key), std::ios::binary);
+    if (!file) {
+        return Empty();
+    }
+    Header header, expected;
+    expected.key = key;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || !(header == expected)) {
+        return Empty();
+    }
+    std::vector<char> binary(header.length);
+    if (!file.read(binary.data(), binary.size())) {
+        return Empty();
+    }
+    Program program;
+    if (separable) {
+        program.set(GL_PROGRAM_SEPARABLE, GL_TRUE);
+    }
+    program.binary(header.format, binary.data(), static_cast<GLsizei>(binary.size()));
+    if (program.name() == 0) {
+        Log::w("Cached program binary {:016x} rejected by driver: {}", key, program.get_info_log());
+    }
+    return program;
+}
+
+void
+BinaryCache::store(std::uint64_t key, const Program& program) const
+{
+    if (!enabled() || program.name() == 0) {
+        return;
+    }
+    Header header;
+    header.key = key;
+    auto&& binary = program.get_binary(header.format);
+    if (binary.empty()) {
+        return;
+    }
+    header.length = static_cast<std::uint32_t>(binary.size());
+    aux_write(aux_path(key), &header, sizeof(header), binary.data(), binary.size());
+}
+
+bool
+BinaryCache::load_introspection(std::uint64_t key, const Program& program) const
+{
+    if (!enabled() || program.name() == 0) {
+        return false;
+    }
+    std::ifstream file(aux_path(key, "int"), std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    Header header, expected;
+    expected.key = key;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || !(header == expected)) {
+        return false;
+    }
+    std::string snapshot(header.length, '\0');
+    if (!file.read(snapshot.data(), snapshot.size())) {
+        return false;
+    }
+    return Introspector::Restore(program, snapshot);
+}
+
+void
+BinaryCache::store_introspection(std::uint64_t key, const Program& program) const
+{
+    if (!enabled() || program.name() == 0) {
+        return;
+    }
+    Header header;
+    header.key = key;
+    auto&& snapshot = Introspector::Snapshot(program);
+    header.length = static_cast<std::uint32_t>(snapshot.size());
+    aux_write(aux_path(key, "int"), &header, sizeof(header), snapshot.data(), snapshot.size());
+}
+
+void
+BinaryCache::aux_write(const FS::path& path, const void* header, std::size_t header_length, const char* data,
+                       std::size_t length)
+{
+    // write aside and rename, so that concurrent instances never see a partial file
+    auto temporary = path;
+    temporary += '.' + std::to_string(std::random_device{}());
+    std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(header), header_length).write(data, length);
+    file.close(); // flushes, which may fail as well, e.g. on a full disk
+    if (!file) {
+        Log::w("Failed to write {}", temporary);
+        std::remove(temporary.c_str());
+        return;
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        Log::w("Failed to store {}", path);
+        std::remove(temporary.c_str());
+    }
+}
+
+FS::path
+BinaryCache::aux_path(std::uint64_t key, const char* extension) const
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.%s", static_cast<unsigned long long>(key), extension);
+    return m_directory / name;
+}
+
+} // namespace OpenGL
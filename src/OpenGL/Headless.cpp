@@ -0,0 +1,103 @@
+/**
+ * @File Headless.cpp
+ * @author Zhen Luo 461652354@qq.com
+ */
+#include <OpenGL/Headless.hpp>
+#include <Options.hpp>
+#include <mutex>
+
+#if defined(HAVE_EGL)
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+
+namespace OpenGL {
+
+#if defined(HAVE_EGL)
+
+namespace {
+
+/// The surfaceless display, initialized once; EGL_NO_DISPLAY if unavailable.
+EGLDisplay
+display()
+{
+    static EGLDisplay display = []()
+    {
+        auto get_display = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+                eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        if (!get_display) {
+            return EGL_NO_DISPLAY;
+        }
+        EGLDisplay ret = get_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        EGLint major, minor;
+        if (ret == EGL_NO_DISPLAY || !eglInitialize(ret, &major, &minor)) {
+            return EGL_NO_DISPLAY;
+        }
+        return ret;
+    }();
+    return display;
+}
+
+} // namespace
+
+HeadlessContext::HeadlessContext()
+{
+    EGLDisplay dpy = display();
+    if (dpy == EGL_NO_DISPLAY) {
+        m_error = "No EGL surfaceless display";
+        return;
+    }
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        m_error = "EGL can't bind OpenGL API";
+        return;
+    }
+    const EGLint attributes[] = {
+            EGL_CONTEXT_MAJOR_VERSION, options.opengl.version.major,
+            EGL_CONTEXT_MINOR_VERSION, options.opengl.version.minor,
+            EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+            EGL_NONE,
+    };
+    m_context = eglCreateContext(dpy, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, attributes);
+    if (m_context == EGL_NO_CONTEXT) {
+        m_context = nullptr;
+        m_error = fmt::format("EGL failed to create OpenGL {}.{} core context: {:#x}", options.opengl.version.major,
+                              options.opengl.version.minor, eglGetError());
+    }
+}
+
+HeadlessContext::~HeadlessContext()
+{
+    if (m_context) {
+        if (eglGetCurrentContext() == m_context) {
+            eglMakeCurrent(display(), EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        }
+        eglDestroyContext(display(), m_context);
+    }
+}
+
+bool
+HeadlessContext::make_current()
+{
+    if (!m_context || !eglMakeCurrent(display(), EGL_NO_SURFACE, EGL_NO_SURFACE, m_context)) {
+        return false;
+    }
+    static std::once_flag loaded;
+    std::call_once(loaded, []() { gladLoadGLLoader(reinterpret_cast<GLADloadproc>(eglGetProcAddress)); });
+    return true;
+}
+
+#else
+
+HeadlessContext::HeadlessContext() : m_error("Built without EGL")
+{}
+
+HeadlessContext::~HeadlessContext() = default;
+
+bool
+HeadlessContext::make_current()
+{ return false; }
+
+#endif
+
+} // namespace OpenGL
@@ -0,0 +1,31 @@
+/**
+ * @File BufferVariable.cpp
+ * @author Zhen Luo 461652354@qq.com
+ */
+#include <OpenGL/Introspection/BufferVariable.hpp>
+
+
+namespace OpenGL {
+
+BufferVariable::BufferVariable(GLuint program, GLint index, std::string_view name, const GLint* values)
+        : Resource(index, name)
+{
+    UNUSED(program);
+    for (size_t i = 0; i < n_fields; ++i) {
+        this->*fields[i] = values[i];
+    }
+    for (size_t i = 0; i < MaxShaderStage; ++i) {
+        referenced[i] = values[n_fields + i];
+    }
+}
+
+std::ostream&
+operator<<(std::ostream& os, const BufferVariable& variable)
+{
+    os << static_cast<const Resource&>(variable) << '\n';
+    os << "type=" << nameOfDataType(variable.type) << ", block_index=" << variable.block_index << ", offset="
+       << variable.offset << '\n';
+    return os;
+}
+
+} // namespace OpenGL
@@ -0,0 +1,78 @@
+/**
+ * @File InterfaceData.cpp
+ * @author Zhen Luo 461652354@qq.com
+ */
+#include <OpenGL/Introspection/InterfaceData.hpp>
+#include <cstring>
+#include <numeric>
+
+
+namespace OpenGL {
+
+namespace details {
+
+namespace {
+
+template <typename T>
+void
+aux_write(std::string& out, const T* data, std::size_t n)
+{ out.append(reinterpret_cast<const char*>(data), n * sizeof(T)); }
+
+template <typename T>
+bool
+aux_read(std::string_view& in, T* data, std::size_t n)
+{
+    if (in.size() / sizeof(T) < n) {
+        return false;
+    }
+    std::memcpy(data, in.data(), n * sizeof(T));
+    in.remove_prefix(n * sizeof(T));
+    return true;
+}
+
+} // namespace
+
+void
+InterfaceData::write(std::string& out) const
+{
+    const GLint header[] = {n_resources, stride, max_name_length, max_n_variables, max_n_compatible_subroutines,
+                            static_cast<GLint>(subroutine_name_lengths.size())};
+    aux_write(out, header, numel(header));
+    aux_write(out, values.data(), values.size());
+    aux_write(out, subroutine_name_lengths.data(), subroutine_name_lengths.size());
+    std::uint64_t size = names_size;
+    aux_write(out, &size, 1);
+    aux_write(out, names.get(), names_size);
+}
+
+bool
+InterfaceData::read(std::string_view& in)
+{
+    GLint header[6];
+    if (!aux_read(in, header, numel(header))) {
+        return false;
+    }
+    n_resources = header[0];
+    stride = header[1];
+    max_name_length = header[2];
+    max_n_variables = header[3];
+    max_n_compatible_subroutines = header[4];
+    if (n_resources < 0 || stride < 0 || header[5] < 0) {
+        return false;
+    }
+    values.resize(static_cast<std::size_t>(n_resources) * stride);
+    subroutine_name_lengths.resize(header[5]);
+    std::uint64_t size = 0;
+    if (!aux_read(in, values.data(), values.size()) ||
+        !aux_read(in, subroutine_name_lengths.data(), subroutine_name_lengths.size()) || !aux_read(in, &size, 1) ||
+        size > in.size()) {
+        return false;
+    }
+    names_size = size;
+    names = std::make_unique<GLchar[]>(names_size);
+    return aux_read(in, names.get(), names_size);
+}
+
+} // namespace details
+
+} // namespace OpenGL
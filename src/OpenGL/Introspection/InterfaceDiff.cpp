@@ -0,0 +1,212 @@
+/**
+ * @File InterfaceDiff.cpp
+ * @author Zhen Luo 461652354@qq.com
+ */
+#include <OpenGL/Introspection/InterfaceDiff.hpp>
+#include <OpenGL/Introspection/Introspector.hpp>
+
+
+namespace OpenGL {
+
+namespace {
+
+/// Component type and number of components of values of uniforms of @p type, as read by glGetUniform*v.
+std::pair<GLenum, GLsizei>
+aux_uniform_components(GLenum type)
+{
+    switch (type) {
+        case GL_FLOAT:
+            return {GL_FLOAT, 1};
+        case GL_FLOAT_VEC2:
+            return {GL_FLOAT, 2};
+        case GL_FLOAT_VEC3:
+            return {GL_FLOAT, 3};
+        case GL_FLOAT_VEC4:
+        case GL_FLOAT_MAT2:
+            return {GL_FLOAT, 4};
+        case GL_FLOAT_MAT2x3:
+        case GL_FLOAT_MAT3x2:
+            return {GL_FLOAT, 6};
+        case GL_FLOAT_MAT2x4:
+        case GL_FLOAT_MAT4x2:
+            return {GL_FLOAT, 8};
+        case GL_FLOAT_MAT3:
+            return {GL_FLOAT, 9};
+        case GL_FLOAT_MAT3x4:
+        case GL_FLOAT_MAT4x3:
+            return {GL_FLOAT, 12};
+        case GL_FLOAT_MAT4:
+            return {GL_FLOAT, 16};
+        case GL_DOUBLE:
+            return {GL_DOUBLE, 1};
+        case GL_DOUBLE_VEC2:
+            return {GL_DOUBLE, 2};
+        case GL_DOUBLE_VEC3:
+            return {GL_DOUBLE, 3};
+        case GL_DOUBLE_VEC4:
+        case GL_DOUBLE_MAT2:
+            return {GL_DOUBLE, 4};
+        case GL_DOUBLE_MAT2x3:
+        case GL_DOUBLE_MAT3x2:
+            return {GL_DOUBLE, 6};
+        case GL_DOUBLE_MAT2x4:
+        case GL_DOUBLE_MAT4x2:
+            return {GL_DOUBLE, 8};
+        case GL_DOUBLE_MAT3:
+            return {GL_DOUBLE, 9};
+        case GL_DOUBLE_MAT3x4:
+        case GL_DOUBLE_MAT4x3:
+            return {GL_DOUBLE, 12};
+        case GL_DOUBLE_MAT4:
+            return {GL_DOUBLE, 16};
+        case GL_UNSIGNED_INT:
+            return {GL_UNSIGNED_INT, 1};
+        case GL_UNSIGNED_INT_VEC2:
+            return {GL_UNSIGNED_INT, 2};
+        case GL_UNSIGNED_INT_VEC3:
+            return {GL_UNSIGNED_INT, 3};
+        case GL_UNSIGNED_INT_VEC4:
+            return {GL_UNSIGNED_INT, 4};
+        case GL_INT_VEC2:
+        case GL_BOOL_VEC2:
+            return {GL_INT, 2};
+        case GL_INT_VEC3:
+        case GL_BOOL_VEC3:
+            return {GL_INT, 3};
+        case GL_INT_VEC4:
+        case GL_BOOL_VEC4:
+            return {GL_INT, 4};
+        default: // int, bool, and opaque types: samplers, images and atomic counters
+            return {GL_INT, 1};
+    }
+}
+
+/// Assign one element of @p n components of @p C to a uniform of scalar or vector type.
+template <typename C>
+void
+aux_uniform_vector(GLuint program, GLint location, GLsizei n, const C* value)
+{
+    if constexpr (std::is_same_v<C, GLfloat>) {
+        const PFNGLPROGRAMUNIFORM1FVPROC setters[] = {glProgramUniform1fv, glProgramUniform2fv,
+                                                      glProgramUniform3fv, glProgramUniform4fv};
+        return setters[n - 1](program, location, 1, value);
+    } else if constexpr (std::is_same_v<C, GLdouble>) {
+        const PFNGLPROGRAMUNIFORM1DVPROC setters[] = {glProgramUniform1dv, glProgramUniform2dv,
+                                                      glProgramUniform3dv, glProgramUniform4dv};
+        return setters[n - 1](program, location, 1, value);
+    } else if constexpr (std::is_same_v<C, GLint>) {
+        const PFNGLPROGRAMUNIFORM1IVPROC setters[] = {glProgramUniform1iv, glProgramUniform2iv,
+                                                      glProgramUniform3iv, glProgramUniform4iv};
+        return setters[n - 1](program, location, 1, value);
+    } else {
+        const PFNGLPROGRAMUNIFORM1UIVPROC setters[] = {glProgramUniform1uiv, glProgramUniform2uiv,
+                                                       glProgramUniform3uiv, glProgramUniform4uiv};
+        return setters[n - 1](program, location, 1, value);
+    }
+}
+
+/// Copy the value of one element of a uniform at @p from_location of @p from to @p to_location of @p to.
+void
+aux_copy_uniform(GLuint from, GLint from_location, GLuint to, GLint to_location, GLenum type)
+{
+    auto[component, n] = aux_uniform_components(type);
+    switch (component) {
+        case GL_FLOAT: {
+            GLfloat value[16];
+            glGetUniformfv(from, from_location, value);
+            switch (type) {
+                case GL_FLOAT_MAT2:
+                    return glProgramUniformMatrix2fv(to, to_location, 1, GL_FALSE, value);
+                case GL_FLOAT_MAT3:
+                    return glProgramUniformMatrix3fv(to, to_location, 1, GL_FALSE, value);
+                case GL_FLOAT_MAT4:
+                    return glProgramUniformMatrix4fv(to, to_location, 1, GL_FALSE, value);
+                case GL_FLOAT_MAT2x3:
+                    return glProgramUniformMatrix2x3fv(to, to_location, 1, GL_FALSE, value);
+                case GL_FLOAT_MAT2x4:
+                    return glProgramUniformMatrix2x4fv(to, to_location, 1, GL_FALSE, value);
+                case GL_FLOAT_MAT3x2:
+                    return glProgramUniformMatrix3x2fv(to, to_location, 1, GL_FALSE, value);
+                case GL_FLOAT_MAT3x4:
+                    return glProgramUniformMatrix3x4fv(to, to_location, 1, GL_FALSE, value);
+                case GL_FLOAT_MAT4x2:
+                    return glProgramUniformMatrix4x2fv(to, to_location, 1, GL_FALSE, value);
+                case GL_FLOAT_MAT4x3:
+                    return glProgramUniformMatrix4x3fv(to, to_location, 1, GL_FALSE, value);
+                default:
+                    return aux_uniform_vector(to, to_location, n, value);
+            }
+        }
+        case GL_DOUBLE: {
+            GLdouble value[16];
+            glGetUniformdv(from, from_location, value);
+            switch (type) {
+                case GL_DOUBLE_MAT2:
+                    return glProgramUniformMatrix2dv(to, to_location, 1, GL_FALSE, value);
+                case GL_DOUBLE_MAT3:
+                    return glProgramUniformMatrix3dv(to, to_location, 1, GL_FALSE, value);
+                case GL_DOUBLE_MAT4:
+                    return glProgramUniformMatrix4dv(to, to_location, 1, GL_FALSE, value);
+                case GL_DOUBLE_MAT2x3:
+                    return glProgramUniformMatrix2x3dv(to, to_location, 1, GL_FALSE, value);
+                case GL_DOUBLE_MAT2x4:
+                    return glProgramUniformMatrix2x4dv(to, to_location, 1, GL_FALSE, value);
+                case GL_DOUBLE_MAT3x2:
+                    return glProgramUniformMatrix3x2dv(to, to_location, 1, GL_FALSE, value);
+                case GL_DOUBLE_MAT3x4:
+                    return glProgramUniformMatrix3x4dv(to, to_location, 1, GL_FALSE, value);
+                case GL_DOUBLE_MAT4x2:
+                    return glProgramUniformMatrix4x2dv(to, to_location, 1, GL_FALSE, value);
+                case GL_DOUBLE_MAT4x3:
+                    return glProgramUniformMatrix4x3dv(to, to_location, 1, GL_FALSE, value);
+                default:
+                    return aux_uniform_vector(to, to_location, n, value);
+            }
+        }
+        case GL_UNSIGNED_INT: {
+            GLuint value[4];
+            glGetUniformuiv(from, from_location, value);
+            return aux_uniform_vector(to, to_location, n, value);
+        }
+        default: {
+            GLint value[4];
+            glGetUniformiv(from, from_location, value);
+            return aux_uniform_vector(to, to_location, n, value);
+        }
+    }
+}
+
+} // namespace
+
+std::string
+InterfaceDiff::summary() const
+{
+    return fmt::format("+{} -{} ~{} >{}", added.size(), removed.size(), retyped.size(), moved.size());
+}
+
+std::size_t
+carry_uniforms(const Program& from, const Program& to, const InterfaceDiff& uniforms)
+{
+    auto&& before = from.interfaces().lock()->uniform();
+    auto&& introspector = to.interfaces().lock();
+    auto&& after = introspector->uniform();
+    std::size_t carried = 0;
+    for (auto&&[b, a] : uniforms.matched) {
+        auto&& old_uniform = before.resources[b];
+        auto&& new_uniform = after.resources[a];
+        if (old_uniform.location == -1 || new_uniform.location == -1) {
+            continue;
+        }
+        // elements of arrays of basic types have consecutive locations
+        for (GLint i = 0; i < new_uniform.asize; ++i) {
+            aux_copy_uniform(from.name(), old_uniform.location + i, to.name(), new_uniform.location + i,
+                             new_uniform.type);
+            // e.g. a resident program installed again, whose shadow tells values of its last use
+            introspector->uniform_shadow.forget(new_uniform.location + i);
+        }
+        ++carried;
+    }
+    return carried;
+}
+
+} // namespace OpenGL
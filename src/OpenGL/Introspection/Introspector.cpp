@@ -3,6 +3,8 @@
  * @author Zhen Luo 461652354@qq.com
  */
 #include <OpenGL/Introspection/Introspector.hpp>
+#include <algorithm>
+#include <cstring>
 
 
 namespace OpenGL {
@@ -24,6 +26,14 @@ operator<<(std::ostream& os, const Introspector& introspector)
         os << "Uniform Block " << *introspector.IUniformBlock;
         os << separator;
     }
+    if (introspector.IBufferVariable) {
+        os << "Buffer Variable " << *introspector.IBufferVariable;
+        os << separator;
+    }
+    if (introspector.IShaderStorageBlock) {
+        os << "Shader Storage Block " << *introspector.IShaderStorageBlock;
+        os << separator;
+    }
     if (introspector.IInput) {
         os << "Program Input " << *introspector.IInput;
         os << separator;
@@ -90,4 +100,98 @@ void
 Introspector::Put(const Program& program)
 { Instances().erase(program.name()); }
 
+namespace {
+
+/// Header of a snapshot.
+struct SnapshotHeader {
+    char magic[4] = {'G', 'S', 'P', 'I'};
+    std::uint32_t version = 2;
+};
+
+} // namespace
+
+std::string
+Introspector::Snapshot(const Program& program)
+{
+    auto&& introspector = Get(program).lock();
+    introspector->uniform();
+    introspector->uniform_block();
+    introspector->buffer_variable();
+    introspector->shader_storage_block();
+    introspector->input();
+    introspector->output();
+    introspector->vertex_subroutine_uniform();
+    introspector->tess_control_subroutine_uniform();
+    introspector->tess_evaluation_subroutine_uniform();
+    introspector->geometry_subroutine_uniform();
+    introspector->fragment_subroutine_uniform();
+    introspector->compute_subroutine_uniform();
+    std::string snapshot;
+    SnapshotHeader header;
+    snapshot.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    introspector->aux_for_each_interface([&snapshot](auto&& interface) { interface->data().write(snapshot); });
+    return snapshot;
+}
+
+bool
+Introspector::Restore(const Program& program, std::string_view snapshot)
+{
+    assert(program.name());
+    if (Instances().count(program.name())) {
+        return true;
+    }
+    SnapshotHeader header, expected;
+    if (snapshot.size() < sizeof(header)) {
+        return false;
+    }
+    std::memcpy(&header, snapshot.data(), sizeof(header));
+    snapshot.remove_prefix(sizeof(header));
+    if (!std::equal(std::begin(header.magic), std::end(header.magic), std::begin(expected.magic)) ||
+        header.version != expected.version) {
+        return false;
+    }
+    auto intro = Shared<Introspector>(new Introspector(program));
+    bool restored = true;
+    intro->aux_for_each_interface([&](auto&& interface)
+                                  {
+                                      using Interface = typename std::decay_t<decltype(interface)>::element_type;
+                                      details::InterfaceData data;
+                                      if (!restored || !data.read(snapshot) || !Interface::Consistent(data)) {
+                                          restored = false;
+                                          return;
+                                      }
+                                      GLint n_resources = 0;
+                                      glGetProgramInterfaceiv(program.name(), Interface::interface,
+                                                              GL_ACTIVE_RESOURCES, &n_resources);
+                                      if constexpr (Interface::InterfaceSubroutine) {
+                                          GLint n_subroutines = 0;
+                                          glGetProgramInterfaceiv(program.name(),
+                                                                  Interface::resource_type::subroutine_interface,
+                                                                  GL_ACTIVE_RESOURCES, &n_subroutines);
+                                          restored = n_subroutines ==
+                                                     static_cast<GLint>(data.subroutine_name_lengths.size());
+                                      }
+                                      if (!restored || n_resources != data.n_resources) {
+                                          restored = false;
+                                          return;
+                                      }
+                                      if constexpr (std::is_same_v<Interface, UniformBlockInterface>) {
+                                          interface = std::make_unique<Interface>(program.name(), std::move(data),
+                                                                                  intro->IUniform->resources);
+                                      } else if constexpr (std::is_same_v<Interface, ShaderStorageBlockInterface>) {
+                                          interface = std::make_unique<Interface>(program.name(), std::move(data),
+                                                                                  intro->IBufferVariable->resources);
+                                      } else {
+                                          interface = std::make_unique<Interface>(program.name(), std::move(data));
+                                      }
+                                  });
+    if (!restored || !snapshot.empty()) {
+        Log::w("Introspection snapshot of program [{}]\"{}\" doesn't match; introspecting live.", program.name(),
+               program.label());
+        return false;
+    }
+    Instances().emplace(program.name(), std::move(intro));
+    return true;
+}
+
 }
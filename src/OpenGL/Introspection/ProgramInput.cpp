@@ -20,7 +20,7 @@ operator<<(std::ostream& os, const ProgramInput& input)
     return os;
 }
 
-ProgramInput::ProgramInput(GLuint program, GLint index, GLchar* name, const GLint* values)
+ProgramInput::ProgramInput(GLuint program, GLint index, std::string_view name, const GLint* values)
         : Resource(index, name)
 {
     for (size_t i = 0; i < n_fields; ++i) {
@@ -17,7 +17,7 @@ operator<<(std::ostream& os, const ProgramOutput& output)
     return os;
 }
 
-ProgramOutput::ProgramOutput(GLuint program, GLint index, GLchar* name, const GLint* values)
+ProgramOutput::ProgramOutput(GLuint program, GLint index, std::string_view name, const GLint* values)
         : Resource(index, name)
 {
     for (size_t i = 0; i < n_fields; ++i) {
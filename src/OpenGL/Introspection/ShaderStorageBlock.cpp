@@ -0,0 +1,58 @@
+/**
+ * @File ShaderStorageBlock.cpp
+ * @author Zhen Luo 461652354@qq.com
+ */
+#include <OpenGL/Introspection/ShaderStorageBlock.hpp>
+
+
+namespace OpenGL {
+
+ShaderStorageBlock::ShaderStorageBlock(GLuint program, GLint index, std::string_view name, const GLint* values,
+                                       const std::vector<BufferVariable>& program_variables)
+        : Resource(index, name)
+{
+    UNUSED(program);
+    //
+    // per block property
+    binding = values[0];
+    size = values[1];
+    for (size_t i = 0; i < MaxShaderStage; ++i) {
+        referenced[i] = values[3 + i];
+    }
+    //
+    // variables in the block, already introspected in interface GL_BUFFER_VARIABLE
+    const GLint n_variables = values[2];
+    const GLint* indices = values + n_properties;
+    variables.reserve(n_variables);
+    for (GLint i = 0; i < n_variables; ++i) {
+        auto&& variable = program_variables[indices[i]];
+        assert(variable.index == indices[i]);
+        variables.push_back(&variable);
+    }
+}
+
+const BufferVariable*
+ShaderStorageBlock::find(std::string_view name) const
+{
+    for (auto v : variables) {
+        if (v->name == name) {
+            return v;
+        }
+    }
+    return nullptr;
+}
+
+std::ostream&
+operator<<(std::ostream& os, const ShaderStorageBlock& block)
+{
+    os << static_cast<const Resource&>(block) << '\n';
+    os << "binding=" << block.binding << ", size=" << block.size << "\n";
+    for (auto v : block.variables) {
+        os << "\n\t" << static_cast<const Resource&>(*v);
+        os << "\n\t" << "type=" << nameOfDataType(v->type) << ", offset=" << v->offset << "\n";
+    }
+    os << '}';
+    return os;
+}
+
+} // namespace OpenGL
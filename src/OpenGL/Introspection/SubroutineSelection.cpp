@@ -0,0 +1,94 @@
+/**
+ * @File SubroutineSelection.cpp
+ * @author Zhen Luo 461652354@qq.com
+ */
+#include <OpenGL/Introspection/SubroutineSelection.hpp>
+#include <algorithm>
+
+
+namespace OpenGL {
+
+void
+SubroutineSelection::select(const std::string& uniform, const std::string& subroutine)
+{
+    m_selected[uniform] = subroutine;
+    ++m_version;
+}
+
+void
+SubroutineSelection::deselect(const std::string& uniform)
+{
+    if (m_selected.erase(uniform)) {
+        ++m_version;
+    }
+}
+
+void
+SubroutineSelection::clear()
+{
+    m_selected.clear();
+    ++m_version;
+}
+
+const Resource*
+SubroutineSelection::subroutine(const SubroutineUniform& uniform) const
+{
+    if (uniform.subroutines.empty()) {
+        return nullptr;
+    }
+    auto it = m_selected.find(uniform.name);
+    if (it != m_selected.end()) {
+        for (auto&& subroutine : uniform.subroutines) {
+            if (subroutine.name == it->second) {
+                return &subroutine;
+            }
+        }
+    }
+    return &uniform.subroutines.front();
+}
+
+void
+SubroutineBinding::apply(const Program& program, ShaderStage stage, const SubroutineSelection& selection)
+{
+    if (m_program != program.name() || m_stage != stage || m_version != selection.version() ||
+        m_introspector.expired()) {
+        aux_resolve(program, stage, selection);
+    }
+    if (!m_indices.empty()) {
+        glUniformSubroutinesuiv(shader_stage_type(stage), static_cast<GLsizei>(m_indices.size()), m_indices.data());
+    }
+}
+
+void
+SubroutineBinding::aux_resolve(const Program& program, ShaderStage stage, const SubroutineSelection& selection)
+{
+    m_program = program.name();
+    m_stage = stage;
+    m_version = selection.version();
+    m_introspector.reset();
+    m_indices.clear();
+    if (m_program == 0) {
+        return;
+    }
+    m_introspector = program.interfaces();
+    auto&& introspector = m_introspector.lock();
+    visit_subroutine_uniforms(*introspector, stage, [this, &selection](auto&& interface)
+    {
+        // every location must be given a subroutine, and elements of arrays have consecutive locations
+        GLint n_locations = 0;
+        for (auto&& uniform : interface.resources) {
+            n_locations = std::max(n_locations, uniform.location + std::max(uniform.asize, 1));
+        }
+        m_indices.assign(n_locations, 0);
+        for (auto&& uniform : interface.resources) {
+            auto* subroutine = selection.subroutine(uniform);
+            if (!subroutine || uniform.location == -1) {
+                continue;
+            }
+            std::fill_n(m_indices.begin() + uniform.location, std::max(uniform.asize, 1),
+                        static_cast<GLuint>(subroutine->index));
+        }
+    });
+}
+
+} // namespace OpenGL
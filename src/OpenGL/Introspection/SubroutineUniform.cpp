@@ -3,27 +3,23 @@
  * @author Zhen Luo 461652354@qq.com
  */
 #include <OpenGL/Introspection/SubroutineUniform.hpp>
+#include <Utility/Debug.hpp>
 
 
 namespace OpenGL {
 
-SubroutineUniform::SubroutineUniform(GLuint program, GLenum stage, GLint index, GLchar* name, const GLint* values)
+SubroutineUniform::SubroutineUniform(GLuint program, GLint index, std::string_view name, const GLint* values,
+                                     const std::vector<Subroutine>& stage_subroutines)
         : Resource(index, name)
 {
+    UNUSED(program);
     asize = values[0];
     location = values[1];
-    GLint n_subroutines;
-    GLint name_length;
-    glGetProgramStageiv(program, stage, GL_ACTIVE_SUBROUTINES, &n_subroutines);
-    glGetProgramStageiv(program, stage, GL_ACTIVE_SUBROUTINE_MAX_LENGTH, &name_length);
-    name_length++;
-    auto&& buffer = std::make_unique<GLchar[]>(name_length);
-    for (GLint i = 0; i < n_subroutines; ++i) {
-        GLsizei len;
-        glGetActiveSubroutineName(program, stage, i, name_length, &len, buffer.get());
-        if (len != 0) {
-            subroutines.emplace_back(i, buffer.get());
-        }
+    const GLint n_compatible = values[2];
+    const GLint* indices = values + n_properties;
+    subroutines.reserve(n_compatible);
+    for (GLint i = 0; i < n_compatible; ++i) {
+        subroutines.push_back(stage_subroutines[indices[i]]);
     }
 }
 
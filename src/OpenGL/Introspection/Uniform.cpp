@@ -6,8 +6,8 @@
 
 
 namespace OpenGL {
-Uniform::Uniform(GLuint program, GLint index, GLchar* name, const GLint* values) : Resource(index,
-                                                                                            name)
+Uniform::Uniform(GLuint program, GLint index, std::string_view name, const GLint* values)
+        : Resource(index, name)
 {
     UNUSED(program);
     for (size_t i = 0; i < n_fields; ++i) {
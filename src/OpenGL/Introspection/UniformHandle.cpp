@@ -0,0 +1,107 @@
+/**
+ * @File UniformHandle.cpp
+ * @author Zhen Luo 461652354@qq.com
+ */
+#include <OpenGL/Introspection/UniformHandle.hpp>
+
+
+namespace OpenGL {
+
+namespace details {
+
+bool
+uniform_accepts(GLenum declared, GLenum supplied)
+{
+    if (declared == supplied) {
+        return true;
+    }
+    switch (declared) {
+        case GL_BOOL:
+            return supplied == GL_FLOAT || supplied == GL_INT || supplied == GL_UNSIGNED_INT;
+        case GL_BOOL_VEC2:
+            return supplied == GL_FLOAT_VEC2 || supplied == GL_INT_VEC2 || supplied == GL_UNSIGNED_INT_VEC2;
+        case GL_BOOL_VEC3:
+            return supplied == GL_FLOAT_VEC3 || supplied == GL_INT_VEC3 || supplied == GL_UNSIGNED_INT_VEC3;
+        case GL_BOOL_VEC4:
+            return supplied == GL_FLOAT_VEC4 || supplied == GL_INT_VEC4 || supplied == GL_UNSIGNED_INT_VEC4;
+        case GL_FLOAT:
+        case GL_FLOAT_VEC2:
+        case GL_FLOAT_VEC3:
+        case GL_FLOAT_VEC4:
+        case GL_DOUBLE:
+        case GL_DOUBLE_VEC2:
+        case GL_DOUBLE_VEC3:
+        case GL_DOUBLE_VEC4:
+        case GL_INT:
+        case GL_INT_VEC2:
+        case GL_INT_VEC3:
+        case GL_INT_VEC4:
+        case GL_UNSIGNED_INT:
+        case GL_UNSIGNED_INT_VEC2:
+        case GL_UNSIGNED_INT_VEC3:
+        case GL_UNSIGNED_INT_VEC4:
+        case GL_FLOAT_MAT2:
+        case GL_FLOAT_MAT3:
+        case GL_FLOAT_MAT4:
+        case GL_FLOAT_MAT2x3:
+        case GL_FLOAT_MAT2x4:
+        case GL_FLOAT_MAT3x2:
+        case GL_FLOAT_MAT3x4:
+        case GL_FLOAT_MAT4x2:
+        case GL_FLOAT_MAT4x3:
+        case GL_DOUBLE_MAT2:
+        case GL_DOUBLE_MAT3:
+        case GL_DOUBLE_MAT4:
+        case GL_DOUBLE_MAT2x3:
+        case GL_DOUBLE_MAT2x4:
+        case GL_DOUBLE_MAT3x2:
+        case GL_DOUBLE_MAT3x4:
+        case GL_DOUBLE_MAT4x2:
+        case GL_DOUBLE_MAT4x3:
+            return false;
+        default: // opaque types: samplers, images and atomic counters
+            return supplied == GL_INT;
+    }
+}
+
+bool
+UniformHandleBase::aux_resolve(const Program& program)
+{
+    m_program = program.name();
+    m_location = -1;
+    m_introspector.reset();
+    m_shadow = nullptr;
+    if (m_program == 0) {
+        return false;
+    }
+    m_introspector = program.interfaces();
+    auto&& introspector = m_introspector.lock();
+    auto uniform = introspector->uniform().find(m_key);
+    if (!uniform) {
+        // not declared, or optimized away by the compiler; either way nothing to assign
+        return false;
+    }
+    if (uniform->location == -1) {
+        Log::w("Program [{}]\"{}\": uniform {} is in a block, and can't be assigned alone.", m_program,
+               introspector->label, m_key.name);
+        return false;
+    }
+    if (!uniform_accepts(uniform->type, m_type)) {
+        Log::w("Program [{}]\"{}\": uniform {} is declared {}, but assigned {}.", m_program, introspector->label,
+               m_key.name, nameOfDataType(uniform->type), nameOfDataType(m_type));
+        return false;
+    }
+    m_elements = m_count;
+    if (m_count > uniform->asize) {
+        Log::w("Program [{}]\"{}\": uniform {} has {} elements, but assigned {}; the rest are dropped.", m_program,
+               introspector->label, m_key.name, uniform->asize, m_count);
+        m_elements = uniform->asize;
+    }
+    m_location = uniform->location;
+    m_shadow = &introspector->uniform_shadow;
+    return true;
+}
+
+} // namespace details
+
+} // namespace OpenGL
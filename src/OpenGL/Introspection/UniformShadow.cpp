@@ -0,0 +1,35 @@
+/**
+ * @File UniformShadow.cpp
+ * @author Zhen Luo 461652354@qq.com
+ */
+#include <OpenGL/Introspection/UniformShadow.hpp>
+#include <cassert>
+#include <cstring>
+
+
+namespace OpenGL {
+
+namespace details {
+
+bool
+UniformShadow::update(GLint location, const void* data, std::size_t size)
+{
+    assert(location >= 0);
+    auto index = static_cast<std::size_t>(location);
+    if (index >= m_values.size()) {
+        m_values.resize(index + 1);
+    }
+    auto&& value = m_values[index];
+    if (value.size() == size && std::memcmp(value.data(), data, size) == 0) {
+        ++Uploads().skipped;
+        return false;
+    }
+    auto bytes = static_cast<const unsigned char*>(data);
+    value.assign(bytes, bytes + size);
+    ++Uploads().issued;
+    return true;
+}
+
+} // namespace details
+
+} // namespace OpenGL
@@ -24,6 +24,43 @@ Program::link()
     return *this;
 }
 
+Program&
+Program::link(Deferred)
+{
+    glLinkProgram(name());
+    return *this;
+}
+
+bool
+Program::completed() const
+{
+    if (name() == 0 || !(GLAD_GL_KHR_parallel_shader_compile || GLAD_GL_ARB_parallel_shader_compile)) {
+        return true;
+    }
+    return get(GL_COMPLETION_STATUS_KHR) == GL_TRUE;
+}
+
+Program&
+Program::binary(GLenum format, const void* binary, GLsizei length)
+{
+    glProgramBinary(name(), format, binary, length);
+    aux_check_link();
+    return *this;
+}
+
+std::vector<char>
+Program::get_binary(GLenum& format) const
+{
+    GLint length = get(GL_PROGRAM_BINARY_LENGTH);
+    if (length <= 0) {
+        return {};
+    }
+    std::vector<char> ret(static_cast<size_t>(length));
+    glGetProgramBinary(name(), length, &length, &format, ret.data());
+    ret.resize(static_cast<size_t>(length));
+    return ret;
+}
+
 Owned<GLchar[]>
 Program::aux_get_info_log() const
 {
@@ -61,6 +98,9 @@ Program::set(GLenum param, GLint value)
 
 Program::~Program()
 {
+    if (name() == 0) {
+        return; // released, moved from or failed to link; nothing to put
+    }
     Introspector::Put(*this);
     pool().put(std::move(m_name));
 }
@@ -74,7 +114,7 @@ Program::aux_check_link()
 {
     if (get(GL_LINK_STATUS) == GL_FALSE) {
         auto&& ptr = aux_get_info_log();
-        m_info_log = ptr.get();
+        m_info_log = ptr ? ptr.get() : "";
         pool().put(std::move(m_name));
         assert(m_name == 0);
     }
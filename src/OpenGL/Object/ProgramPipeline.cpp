@@ -10,10 +10,42 @@ namespace OpenGL {
 ProgramPipeline&
 ProgramPipeline::use_stage(const Program& program, GLbitfield bits)
 {
-    glUseProgramStages(name(), bits, program.name());
+    if (aux_record(program.name(), bits)) {
+        glUseProgramStages(name(), bits, program.name());
+    }
     return *this;
 }
 
+ProgramPipeline&
+ProgramPipeline::use_stage(const Shared<Program>& program, GLbitfield bits)
+{
+    GLuint program_name = program ? program->name() : 0;
+    if (aux_record(program_name, bits)) {
+        glUseProgramStages(name(), bits, program_name);
+    }
+    for (std::size_t i = 0; i < MaxShaderStage; ++i) {
+        if (bits & shader_stage_bit(static_cast<ShaderStage>(i))) {
+            m_held[i] = program;
+        }
+    }
+    return *this;
+}
+
+bool
+ProgramPipeline::aux_record(GLuint program, GLbitfield bits)
+{
+    bool changed = false;
+    for (std::size_t i = 0; i < MaxShaderStage; ++i) {
+        if ((bits & shader_stage_bit(static_cast<ShaderStage>(i))) && m_stages[i] != program) {
+            m_stages[i] = program;
+            m_held[i] = nullptr;
+            changed = true;
+        }
+    }
+    m_validated = m_validated && !changed;
+    return changed;
+}
+
 std::unique_ptr<GLchar[]>
 ProgramPipeline::get_info_log() const
 {
@@ -34,8 +66,13 @@ ProgramPipeline::get(GLenum param) const
 bool
 ProgramPipeline::valid() const
 {
-    glValidateProgramPipeline(name());
-    return get(GL_VALIDATE_STATUS) == GL_TRUE;
+    if (!m_validated) {
+        glValidateProgramPipeline(name());
+        m_valid = get(GL_VALIDATE_STATUS) == GL_TRUE;
+        m_info_log = m_valid ? std::string() : std::string(get_info_log().get());
+        m_validated = true;
+    }
+    return m_valid;
 }
 
 } // namespace OpenGL
@@ -0,0 +1,90 @@
+/**
+ * @File StorageBuffer.cpp
+ * @author Zhen Luo 461652354@qq.com
+ */
+#include <OpenGL/StorageBuffer.hpp>
+#include <cstring>
+
+
+namespace OpenGL {
+
+StorageBuffer::StorageBuffer(GLsizeiptr size, GLsizei n_slots)
+        : m_size(size), m_current(n_slots - 1), m_fences(n_slots, nullptr)
+{
+    assert(n_slots > 0);
+    GLint alignment = 1;
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    alignment = std::max(alignment, 1);
+    m_stride = (size + alignment - 1) / alignment * alignment;
+    m_buffer.bind(GL_SHADER_STORAGE_BUFFER);
+    if (GLAD_GL_ARB_buffer_storage || GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 4)) {
+        constexpr GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        // dynamic, in case it can't be mapped after all
+        glBufferStorage(GL_SHADER_STORAGE_BUFFER, m_stride * n_slots, nullptr, access | GL_DYNAMIC_STORAGE_BIT);
+        m_mapped = static_cast<unsigned char*>(Buffer::MapRange(GL_SHADER_STORAGE_BUFFER, 0, m_stride * n_slots,
+                                                                access));
+    } else {
+        Buffer::Data(GL_SHADER_STORAGE_BUFFER, m_stride * n_slots, nullptr, GL_DYNAMIC_DRAW);
+    }
+    if (!m_mapped) {
+        Log::w("Shader storage buffer [{}] can't be mapped persistently; copied on flush instead.", m_buffer.name());
+        m_staging = std::make_unique<unsigned char[]>(size);
+    }
+}
+
+StorageBuffer::~StorageBuffer()
+{
+    for (auto fence : m_fences) {
+        if (fence) {
+            glDeleteSync(fence);
+        }
+    }
+    if (persistent()) {
+        m_buffer.bind(GL_SHADER_STORAGE_BUFFER);
+        Buffer::Unmap(GL_SHADER_STORAGE_BUFFER);
+    }
+}
+
+void*
+StorageBuffer::next()
+{
+    auto&& last = m_fences[m_current];
+    if (last) {
+        glDeleteSync(last);
+    }
+    last = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    m_current = (m_current + 1) % static_cast<GLsizei>(m_fences.size());
+    if (auto&& fence = m_fences[m_current]) {
+        constexpr GLuint64 timeout = 1'000'000'000; // 1s, in ns
+        GLenum status;
+        do {
+            status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+        } while (status == GL_TIMEOUT_EXPIRED);
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+    return data();
+}
+
+void
+StorageBuffer::flush(GLintptr offset, GLsizeiptr length)
+{
+    if (persistent()) {
+        return;
+    }
+    if (length < 0) {
+        length = m_size - offset;
+    }
+    m_buffer.bind(GL_SHADER_STORAGE_BUFFER);
+    // the slot is not read by any command in flight, having been waited for by next()
+    auto* mapped = Buffer::MapRange(GL_SHADER_STORAGE_BUFFER, this->offset() + offset, length,
+                                    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (mapped) {
+        std::memcpy(mapped, m_staging.get() + offset, length);
+        Buffer::Unmap(GL_SHADER_STORAGE_BUFFER);
+    } else {
+        Buffer::Update(GL_SHADER_STORAGE_BUFFER, this->offset() + offset, length, m_staging.get() + offset);
+    }
+}
+
+} // namespace OpenGL
@@ -0,0 +1,62 @@
+/**
+ * @File UniformRing.cpp
+ * @author Zhen Luo 461652354@qq.com
+ */
+#include <OpenGL/UniformRing.hpp>
+#include <cstring>
+
+
+namespace OpenGL {
+
+UniformRing::UniformRing(GLsizeiptr size, GLsizei n_slots)
+        : m_size(size), m_current(n_slots - 1), m_fences(n_slots, nullptr)
+{
+    assert(n_slots > 0);
+    GLint alignment = 1;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    alignment = std::max(alignment, 1);
+    m_stride = (size + alignment - 1) / alignment * alignment;
+    m_buffer.bind(GL_UNIFORM_BUFFER);
+    Buffer::Data(GL_UNIFORM_BUFFER, m_stride * n_slots, nullptr, GL_DYNAMIC_DRAW);
+}
+
+UniformRing::~UniformRing()
+{
+    for (auto fence : m_fences) {
+        if (fence) {
+            glDeleteSync(fence);
+        }
+    }
+}
+
+void
+UniformRing::write(const void* data)
+{
+    auto&& last = m_fences[m_current];
+    if (last) {
+        glDeleteSync(last);
+    }
+    last = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    m_current = (m_current + 1) % static_cast<GLsizei>(m_fences.size());
+    if (auto&& fence = m_fences[m_current]) {
+        constexpr GLuint64 timeout = 1'000'000'000; // 1s, in ns
+        GLenum status;
+        do {
+            status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+        } while (status == GL_TIMEOUT_EXPIRED);
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+    m_buffer.bind(GL_UNIFORM_BUFFER);
+    auto* mapped = Buffer::MapRange(GL_UNIFORM_BUFFER, offset(), m_size, GL_MAP_WRITE_BIT |
+                                                                          GL_MAP_INVALIDATE_RANGE_BIT |
+                                                                          GL_MAP_UNSYNCHRONIZED_BIT);
+    if (mapped) {
+        std::memcpy(mapped, data, m_size);
+        Buffer::Unmap(GL_UNIFORM_BUFFER);
+    } else {
+        Buffer::Update(GL_UNIFORM_BUFFER, offset(), m_size, data);
+    }
+}
+
+} // namespace OpenGL
@@ -5,6 +5,7 @@
 #include <Console.hpp>
 #include <Utility/Misc.hpp>
 
+#include <cstdlib>
 #include <iostream>
 
 
@@ -15,7 +16,13 @@ GlobalOptions::GlobalOptions() :
                      APP_VERSION,
                      DEBUG_BUILD ? "debug" : "release",
                      "\n***based on glslViewer 1.5.6 by Patricio Gonzalez Vivo(patriciogonzalezvivo.com)***"})
-{}
+{
+    if (auto* xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) {
+        opengl.cache_dir = FS::path(xdg) / "GLSLSpec";
+    } else if (auto* home = std::getenv("HOME"); home && *home) {
+        opengl.cache_dir = FS::path(home) / ".cache" / "GLSLSpec";
+    }
+}
 
 namespace {
 
@@ -136,6 +143,71 @@ const std::vector<NamedOption> NamedOptions = {
                     Log::i("Application will quit after {}ms.", options.application.TTL);
                     return 1u;
                 }},
+        {"",  {"settle"},
+                "Wait until a changed file goes quiet for this long before reloading it. (milliseconds)",
+                {1, 1}, {"ms"},
+                [](const std::string&, unsigned, const std::string* arg) -> unsigned
+                {
+                    options.watch.settle = std::max(0.0f, string_to<float>(*arg));
+                    return 1u;
+                }},
+        {"",  {"watch"},
+                "Watch a directory tree for shaders matching a glob pattern, e.g. 'shaders/**/*.frag', importing them once created or modified",
+                {1, 1}, {"glob"},
+                [](const std::string&, unsigned, const std::string* arg) -> unsigned
+                {
+                    options.watch.trees.emplace_back(*arg);
+                    return 1u;
+                }},
+        {"",  {"variants"},
+                "Remember at most this many shader variants (file, stage and macros) for instant switching. (256 by default)",
+                {1, 1}, {"count"},
+                [](const std::string&, unsigned, const std::string* arg) -> unsigned
+                {
+                    options.opengl.variants = std::max(1, string_to<int>(*arg));
+                    return 1u;
+                }},
+        {"",  {"resident-memory"},
+                "Keep linked programs taking up to this much memory resident for instant toggling and reimporting. (MiB)",
+                {1, 1}, {"MiB"},
+                [](const std::string&, unsigned, const std::string* arg) -> unsigned
+                {
+                    options.opengl.resident_memory =
+                            static_cast<std::size_t>(std::max(0.0f, string_to<float>(*arg)) * (1 << 20));
+                    return 1u;
+                }},
+        {"",  {"monolithic"},
+                "Link user shaders into one monolithic program instead of a pipeline of separable ones",
+                {0, 0}, {},
+                [](const std::string&, unsigned, const std::string*) -> unsigned
+                {
+                    options.opengl.monolithic = true;
+                    return 0u;
+                }},
+        {"",  {"cache-dir"},
+                "Cache compiled program binaries in this directory, '' to disable. ($XDG_CACHE_HOME/GLSLSpec by default)",
+                {1, 1}, {"dir"},
+                [](const std::string&, unsigned, const std::string* arg) -> unsigned
+                {
+                    options.opengl.cache_dir = *arg;
+                    return 1u;
+                }},
+        {"",  {"validate"},
+                "Compile every shader under a directory without a display, print a JSON Lines report and exit",
+                {1, 1}, {"dir"},
+                [](const std::string&, unsigned, const std::string* arg) -> unsigned
+                {
+                    options.validate.directory = *arg;
+                    return 1u;
+                }},
+        {"j", {"jobs"},
+                "Number of threads used by --validate. (all hardware threads by default)",
+                {1, 1}, {"count"},
+                [](const std::string&, unsigned, const std::string* arg) -> unsigned
+                {
+                    options.validate.jobs = static_cast<unsigned>(std::max(0, string_to<int>(*arg)));
+                    return 1u;
+                }},
         {"o", {"out",  "output"},
                 "Save a screen shot before exiting to the specified file",
                 {1, 1}, {"file"},
@@ -0,0 +1,335 @@
+/**
+ * @File Preprocessor.cpp
+ * @author Zhen Luo 461652354@qq.com
+ */
+#include <Preprocessor.hpp>
+#include <Options.hpp>
+#include <Utility/Log.hpp>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+
+
+namespace {
+
+expected<std::string, std::string>
+read_file(const FS::path& path)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        return make_unexpected("Failed to open file " + path.string());
+    }
+    std::string content(static_cast<std::size_t>(file.tellg()), '\0');
+    file.seekg(0);
+    if (!file.read(&content[0], content.size())) {
+        return make_unexpected("Failed to read file " + path.string());
+    }
+    return content;
+}
+
+inline const char*
+skip_blank(const char* it, const char* end)
+{
+    while (it < end && (*it == ' ' || *it == '\t' || *it == '\r')) {
+        ++it;
+    }
+    return it;
+}
+
+/// Read an identifier at @p it, returning it and moving @p it past it.
+inline std::string_view
+read_word(const char*& it, const char* end)
+{
+    auto begin = it;
+    while (it < end && (std::isalnum(static_cast<unsigned char>(*it)) || *it == '_')) {
+        ++it;
+    }
+    return {begin, static_cast<std::size_t>(it - begin)};
+}
+
+/// Track whether the end of line [@p it, @p end) is inside a block comment, given whether its beginning is.
+bool
+in_block_comment(const char* it, const char* end, bool in_comment)
+{
+    while (it < end) {
+        if (in_comment) {
+            it = static_cast<const char*>(std::memchr(it, '*', end - it));
+            if (!it) {
+                break;
+            }
+            if (it + 1 < end && it[1] == '/') {
+                in_comment = false;
+                ++it;
+            }
+        } else {
+            it = static_cast<const char*>(std::memchr(it, '/', end - it));
+            if (!it || it + 1 == end || it[1] == '/') {
+                break;
+            }
+            if (it[1] == '*') {
+                in_comment = true;
+                ++it;
+            }
+        }
+        ++it;
+    }
+    return in_comment;
+}
+
+enum class Directive {
+    Version,
+    Include,
+    Other,
+};
+
+/// Recognize the directive on a line whose first non-blank character '#' is right before @p it.
+/// @param name Receives the quoted file name if it's an '#include'.
+Directive
+parse_directive(const char* it, const char* end, std::string_view& name)
+{
+    it = skip_blank(it, end);
+    auto&& word = read_word(it, end);
+    if (word == "version") {
+        return Directive::Version;
+    }
+    if (word == "pragma") {
+        it = skip_blank(it, end);
+        word = read_word(it, end);
+    } else if (word != "include") {
+        return Directive::Other;
+    }
+    if (word != "include") {
+        return Directive::Other;
+    }
+    it = skip_blank(it, end);
+    if (it == end || (*it != '"' && *it != '<')) {
+        return Directive::Other;
+    }
+    auto close = *it == '"' ? '"' : '>';
+    auto begin = ++it;
+    it = static_cast<const char*>(std::memchr(it, close, end - it));
+    if (!it) {
+        return Directive::Other;
+    }
+    name = {begin, static_cast<std::size_t>(it - begin)};
+    return Directive::Include;
+}
+
+std::string
+include_folders()
+{
+    std::string folders;
+    for (const auto& folder : options.includes) {
+        folders += "\n\t";
+        folders += folder;
+    }
+    return folders.empty() ? "\n\t<none>" : folders;
+}
+
+} // namespace
+
+expected<const SourceFiles::File*, std::string>
+SourceFiles::get(const FS::path& path)
+{
+    auto it = m_files.find(path);
+    if (it == m_files.end()) {
+        auto&& content = read_file(path);
+        if (!content) {
+            return make_unexpected(content.error());
+        }
+        auto hash = hash64(*content);
+        it = m_files.emplace(path, File{std::move(*content), hash}).first;
+    }
+    return &it->second;
+}
+
+expected<FS::FileList, std::string>
+scan_includes(const FS::path& file, SourceFiles& files)
+{
+    auto&& source = files.get(file);
+    if (!source) {
+        return make_unexpected(source.error());
+    }
+    auto&& content = (*source)->content;
+    const char* const end = content.data() + content.size();
+    FS::FileList ret;
+    bool in_comment = false;
+    for (const char* it = content.data(); it < end;) {
+        auto eol = static_cast<const char*>(std::memchr(it, '\n', end - it));
+        if (!eol) {
+            eol = end;
+        }
+        const char* hash = skip_blank(it, eol);
+        std::string_view name;
+        if (in_comment || hash == eol || *hash != '#') {
+            in_comment = in_block_comment(it, eol, in_comment);
+        } else if (parse_directive(hash + 1, eol, name) == Directive::Include) {
+            FS::path dependency = FS::resolve_url(file.parent_path(), std::string(name));
+            if (!dependency.empty() && std::find(ret.begin(), ret.end(), dependency) == ret.end()) {
+                ret.push_back(std::move(dependency));
+            }
+        }
+        it = eol == end ? end : eol + 1;
+    }
+    return ret;
+}
+
+struct Preprocessor::State {
+    PreprocessedSource result;
+    /// Index of each file in result.files.
+    std::unordered_map<FS::path, std::size_t> indices;
+    /// Whether each file in result.files is being expanded, i.e. on the include stack.
+    std::vector<bool> expanding;
+    /// Line number the next line appended to result.source will have.
+    std::size_t expanded = 1;
+    bool version_found = false;
+};
+
+void
+Preprocessor::define(const std::string& macro)
+{
+    auto pos = m_defines.size() + 8;
+    m_defines += "#define ";
+    m_defines += macro;
+    pos = m_defines.find('=', pos);
+    if (pos != std::string::npos) {
+        m_defines[pos] = ' ';
+    }
+    m_defines += '\n';
+    ++m_define_count;
+}
+
+expected<PreprocessedSource, std::string>
+Preprocessor::process(const FS::path& file) const
+{
+    auto&& canonical = FS::canonical(file.string());
+    if (!canonical) {
+        return make_unexpected(canonical.error());
+    }
+    State state;
+    state.result.files.push_back(*canonical);
+    state.indices.emplace(*canonical, 0);
+    state.expanding.push_back(false);
+    if (auto&& ex = aux_expand(state, 0); !ex) {
+        return make_unexpected(ex.error());
+    }
+    if (!state.version_found) {
+        Log::w("Could not locate '#version' directive; defining macros in the beginning of shader...");
+        state.result.source.insert(0, m_defines);
+        state.result.lines.prepend_generated(m_define_count);
+    }
+    return std::move(state.result);
+}
+
+expected<void, std::string>
+Preprocessor::aux_expand(State& state, std::size_t index) const
+{
+    const FS::path path = state.result.files[index]; // XXX copy, files might grow
+    std::string storage;
+    const std::string* content = &storage;
+    if (m_files) {
+        auto&& file = m_files->get(path);
+        if (!file) {
+            return make_unexpected(file.error());
+        }
+        content = &(*file)->content;
+    } else if (auto&& ex = read_file(path)) {
+        storage = std::move(*ex);
+    } else {
+        return make_unexpected(ex.error());
+    }
+    state.expanding[index] = true;
+    auto& out = state.result.source;
+    auto& lines = state.result.lines;
+    auto file_index = static_cast<LineMap::FileIndex>(index);
+    out.reserve(out.size() + content->size() + m_defines.size());
+    const char* const end = content->data() + content->size();
+    const char* span = content->data(); // beginning of content not yet copied
+    std::size_t span_line = 1; // line number of span
+    // copy the span up to line @p line beginning at @p to
+    auto&& flush = [&](const char* to, std::size_t line)
+    {
+        out.append(span, to - span);
+        state.expanded += line - span_line;
+    };
+    lines.add(state.expanded, file_index, 1);
+    bool in_comment = false;
+    std::size_t line = 1;
+    for (const char* it = span; it < end; ++line) {
+        auto eol = static_cast<const char*>(std::memchr(it, '\n', end - it));
+        if (!eol) {
+            eol = end;
+        }
+        const char* next = eol == end ? end : eol + 1;
+        const char* hash = skip_blank(it, eol);
+        if (in_comment || hash == eol || *hash != '#') {
+            in_comment = in_block_comment(it, eol, in_comment);
+            it = next;
+            continue;
+        }
+        std::string_view name;
+        switch (parse_directive(hash + 1, eol, name)) {
+            case Directive::Version:
+                if (index != 0) {
+                    Log::w("Ignored '#version' in included file {}:{}", path, line);
+                    flush(it, line);
+                    out += '\n';
+                    ++state.expanded;
+                } else if (!state.version_found) {
+                    flush(next, line + 1);
+                    if (next == end) {
+                        out += '\n';
+                    }
+                    lines.add(state.expanded, LineMap::Generated, 1);
+                    out += m_defines;
+                    state.expanded += m_define_count;
+                    lines.add(state.expanded, file_index, line + 1);
+                    state.version_found = true;
+                } else {
+                    it = next; // let the compiler complain
+                    continue;
+                }
+                break;
+            case Directive::Include: {
+                flush(it, line);
+                auto&& dependency = FS::resolve_url(path.parent_path(), std::string(name));
+                if (dependency.empty()) {
+                    return make_unexpected("Can not resolve file: " + std::string(name) + "\nincluded by: " +
+                                           path.string() + ':' + std::to_string(line) +
+                                           "\nAddtional include folders:" + include_folders());
+                }
+                auto&&[found, inserted] = state.indices.emplace(dependency, state.result.files.size());
+                auto included = found->second;
+                if (!inserted) {
+                    if (state.expanding[included]) {
+                        return make_unexpected("Cyclic include of " + dependency + " by " + path.string() + ':' +
+                                               std::to_string(line));
+                    }
+                    out += '\n'; // already included; keep line numbers in sync
+                    ++state.expanded;
+                    break;
+                }
+                state.result.files.emplace_back(dependency);
+                state.expanding.push_back(false);
+                if (auto&& ex = aux_expand(state, included); !ex) {
+                    return ex;
+                }
+                lines.add(state.expanded, file_index, line + 1);
+                break;
+            }
+            case Directive::Other:
+                it = next;
+                continue;
+        }
+        span = it = next;
+        span_line = line + 1;
+    }
+    flush(end, line);
+    if (span < end && end[-1] != '\n') {
+        out += '\n';
+    }
+    state.expanding[index] = false;
+    return {};
+}
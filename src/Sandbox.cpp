@@ -7,7 +7,11 @@
 #include <Options.hpp>
 #include <Window.hpp>
 #include <tol/tiny_obj_loader.h>
-#include <regex>
+#include <Preprocessor.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <numeric>
 
 
 #define STB_IMAGE_IMPLEMENTATION
@@ -32,6 +36,7 @@ const glm::vec3 tex1[] = {
         glm::vec3(0.0f), glm::vec3(1.0f),
 };
 
+
 } // namespace
 
 // TODO supply reasonable default shader
@@ -105,30 +110,26 @@ Sandbox::Sandbox(Watcher& watcher) : watcher(watcher)
     m_pipeline_user.bind().label("[user]");
     // initialize internal OpenGL objects
     m_vao_internal.bind().label("[internal]");
-    m_pipeline_internal.bind().label("[internal]");
+    m_pipeline_debug.bind().label("[debug]");
+    m_pipeline_background.bind().label("[background]");
+    m_pipeline_postprocess.bind().label("[postprocess]");
     // initialize debug shaders
-    OpenGL::Shader axes_vert(GL_VERTEX_SHADER), axes_frag(GL_FRAGMENT_SHADER);
-    axes_vert.source(axes_vert_source).compile();
-    axes_frag.source(axes_frag_source).compile();
-    m_debug_axes.set(GL_PROGRAM_SEPARABLE, GL_TRUE).attach(axes_vert).attach(axes_frag).link();
+    m_debug_axes = aux_link_internal({{GL_VERTEX_SHADER,   &axes_vert_source},
+                                      {GL_FRAGMENT_SHADER, &axes_frag_source}});
     if (m_debug_axes.name() == 0) {
         ERROR("Debug drawing axes shader program invalid!");
     } else {
         m_debug_axes.label("[internal]axes");
     }
     // initialize background vertex shader
-    OpenGL::Shader background_vert(GL_VERTEX_SHADER);
-    background_vert.source(background_vert_source).compile();
-    m_background_vert.set(GL_PROGRAM_SEPARABLE, GL_TRUE).attach(background_vert).link();
+    m_background_vert = aux_link_internal({{GL_VERTEX_SHADER, &background_vert_source}});
     if (m_background_vert.name() == 0) {
         ERROR("Background rendering vertex shader invalid!");
     } else {
         m_background_vert.label("[background]vertex");
     }
     // initialize postprocessing
-    OpenGL::Shader postprocess_vert(GL_VERTEX_SHADER);
-    postprocess_vert.source(postprocess_vert_source).compile();
-    m_postprocess_vert.set(GL_PROGRAM_SEPARABLE, GL_TRUE).attach(postprocess_vert).link();
+    m_postprocess_vert = aux_link_internal({{GL_VERTEX_SHADER, &postprocess_vert_source}});
     if (m_postprocess_vert.name() == 0) {
         ERROR("Postprocess rendering vertex shader invalid!");
     } else {
@@ -138,14 +139,36 @@ Sandbox::Sandbox(Watcher& watcher) : watcher(watcher)
     aux_allocate_framebuffer_texture(main_window->frame_buffer_size());
 }
 
+OpenGL::Program
+Sandbox::aux_link_internal(std::initializer_list<OpenGL::BinaryCache::Stage> stages)
+{
+    auto key = m_binaries.key(stages);
+    auto program = m_binaries.load(key);
+    if (program.name() != 0) {
+        return program;
+    }
+    program = OpenGL::Program();
+    program.set(GL_PROGRAM_SEPARABLE, GL_TRUE);
+    std::vector<OpenGL::Shader> shaders;
+    for (auto&&[type, source] : stages) {
+        shaders.emplace_back(type);
+        shaders.back().source(*source).compile();
+        program.attach(shaders.back());
+    }
+    program.link();
+    m_binaries.store(key, program);
+    return program;
+}
+
 void
-Sandbox::import(ImportedFile file, bool add_to_watch)
+Sandbox::import(const ImportedFile& file, bool add_to_watch)
 {
     if (file.path().empty()) {
         Log::w("File to import has empty path, ignored...");
         return;
     }
     Log::i("Importing {}", file.path());
+    m_sources.invalidate(file.path());
     bool result;
     switch (file.type()) {
         case FileType::Shader:
@@ -182,52 +205,52 @@ Sandbox::aux_import_shader(const ImportedFile& file)
     ImportedFile original;
     if (file.tag == "user") {
         original = m_programs_user[n].file;
-        m_programs_user[n] = aux_compile(file, stage, ShaderUsage::User);
-        Log::i("User shader {} imported", m_programs_user[n].program.label());
+        aux_compile(m_programs_user[n], file, stage, ShaderUsage::User);
     } else if (file.tag == "background") {
         original = m_background_frag.file;
-        m_background_frag = aux_compile(file, stage, ShaderUsage::Background);
-        Log::i("Background shader {} imported", m_background_frag.program.label());
+        aux_compile(m_background_frag, file, stage, ShaderUsage::Background);
     } else if (file.tag == "postprocess") {
         original = m_postprocess_frag.file;
-        m_postprocess_frag = aux_compile(file, stage, ShaderUsage::Postprocess);
-        Log::i("Postprocess shader {} imported", m_postprocess_frag.program.label());
+        aux_compile(m_postprocess_frag, file, stage, ShaderUsage::Postprocess);
     }
     if (!original.path().empty() && original != file) {
         watcher.unwatch(original.path(), original.tag);
+        for (auto usage : {ShaderUsage::User, ShaderUsage::Background, ShaderUsage::Postprocess}) {
+            m_translation_units.erase(std::make_pair(original.path(), usage));
+        }
+        for (auto&& removed : m_includes.remove_root(original.path()).removed) {
+            watcher.unwatch(removed, "dependency");
+            m_sources.invalidate(removed);
+        }
     }
+    aux_update_includes(file.path(), true);
     return true;
 }
 
-std::string
-Sandbox::aux_preprocess_shader_source(std::string source, const std::vector<std::string>& extra_defines)
+void
+Sandbox::aux_update_includes(const FS::path& file, bool root)
 {
-    // TODO anchor ('$') seems not to work??
-    std::regex version("^[:space:]*#version[^\r\n]*", std::regex_constants::basic);
-    std::smatch match;
-    std::string::const_iterator it = source.begin();
-    if (!std::regex_search(source, match, version)) {
-        Log::w("Could not locate '#version' directive; defining macros in the beginning of shader...");
-    } else {
-        it = match[0].second + 1; // still <= source.end()
-    }
-    static auto&& add_define = [](std::string& str, const auto& defines)
-    {
-        for (auto& macro : defines) {
-            std::string define = "#define " + macro + '\n';
-            auto pos = define.find_first_of('=');
-            if (pos != std::string::npos) {
-                define[pos] = ' ';
+    FS::FileList to_scan{file};
+    while (!to_scan.empty()) {
+        auto current = std::move(to_scan.back());
+        to_scan.pop_back();
+        auto&& includes = scan_includes(current, m_sources);
+        if (!includes) {
+            Log::e("{}", includes.error());
+            continue;
+        }
+        auto&& changes = m_includes.update(current, *includes, root && current == file);
+        for (auto&& added : changes.added) {
+            if (added != current) {
+                watcher.watch(added, FileType::Dependency, "dependency");
+                to_scan.push_back(added);
             }
-            str += define;
         }
-    };
-    std::string defines;
-    add_define(defines, options.defines);
-    add_define(defines, extra_defines);
-    defines += "#line 2\n"; // recalibrate line number so compile/link errors are still displayed correctly.
-    source.insert(it, defines.begin(), defines.end());
-    return source;
+        for (auto&& removed : changes.removed) {
+            watcher.unwatch(removed, "dependency");
+            m_sources.invalidate(removed);
+        }
+    }
 }
 
 bool
@@ -265,7 +288,6 @@ Sandbox::aux_import_geometry(const ImportedFile& file)
         auto parent_path = file.path();
         parent_path.remove_filename();
         bool result = tinyobj::LoadObj(&attributes, &shapes, &materials, &err, path.c_str(), parent_path.c_str(), true);
-        // TODO use materials
         if (!err.empty()) {
             Log::w("{}", err);
         }
@@ -290,6 +312,7 @@ Sandbox::aux_import_geometry(const ImportedFile& file)
             Owned<VertexBuffer<glm::vec3>> positions;
             Owned<VertexBuffer<glm::vec3>> normals;
             Owned<VertexBuffer<glm::vec2>> tex_coords;
+            std::vector<MeshBase::Part> parts;
             {
                 VertexBuffer<glm::vec3>::MappedPtr ppos;
                 VertexBuffer<glm::vec3>::MappedPtr pnorms;
@@ -311,23 +334,43 @@ Sandbox::aux_import_geometry(const ImportedFile& file)
                     tex_coords->data(mesh.indices.size() * sizeof(glm::vec2), nullptr, GL_STATIC_DRAW);
                     puvs = tex_coords->map();
                 }
-                for (auto& index : mesh.indices) {
-                    if (positions) {
-                        *ppos = {attributes.vertices[3 * index.vertex_index],
-                                 attributes.vertices[3 * index.vertex_index + 1],
-                                 attributes.vertices[3 * index.vertex_index + 2]};
-                        ++ppos;
+                // faces sorted by material, to draw those of each material at once
+                std::vector<std::size_t> faces(mesh.num_face_vertices.size());
+                std::iota(faces.begin(), faces.end(), 0);
+                auto&& material_of = [&mesh, &materials](std::size_t face)
+                {
+                    auto id = face < mesh.material_ids.size() ? mesh.material_ids[face] : -1;
+                    return id >= 0 && static_cast<std::size_t>(id) < materials.size() ? id : -1;
+                };
+                std::stable_sort(faces.begin(), faces.end(), [&material_of](std::size_t a, std::size_t b)
+                { return material_of(a) < material_of(b); });
+                for (std::size_t i = 0; i < faces.size(); ++i) {
+                    auto material = material_of(faces[i]);
+                    if (parts.empty() || parts.back().material != material) {
+                        parts.push_back({static_cast<GLint>(3 * i), 0, material});
                     }
-                    if (normals) {
-                        *pnorms = {attributes.normals[3 * index.normal_index],
-                                   attributes.normals[3 * index.normal_index + 1],
-                                   attributes.normals[3 * index.normal_index + 2]};
-                        ++pnorms;
-                    }
-                    if (tex_coords) {
-                        *puvs = {attributes.texcoords[2 * index.texcoord_index],
-                                 attributes.texcoords[2 * index.texcoord_index + 1]};
-                        ++puvs;
+                    parts.back().count += 3;
+                }
+                for (auto face : faces) {
+                    for (std::size_t k = 3 * face; k < 3 * face + 3; ++k) {
+                        auto& index = mesh.indices[k];
+                        if (positions) {
+                            *ppos = {attributes.vertices[3 * index.vertex_index],
+                                     attributes.vertices[3 * index.vertex_index + 1],
+                                     attributes.vertices[3 * index.vertex_index + 2]};
+                            ++ppos;
+                        }
+                        if (normals) {
+                            *pnorms = {attributes.normals[3 * index.normal_index],
+                                       attributes.normals[3 * index.normal_index + 1],
+                                       attributes.normals[3 * index.normal_index + 2]};
+                            ++pnorms;
+                        }
+                        if (tex_coords) {
+                            *puvs = {attributes.texcoords[2 * index.texcoord_index],
+                                     attributes.texcoords[2 * index.texcoord_index + 1]};
+                            ++puvs;
+                        }
                     }
                 }
             }
@@ -336,7 +379,15 @@ Sandbox::aux_import_geometry(const ImportedFile& file)
                                                                                 std::move(positions),
                                                                                 std::move(normals),
                                                                                 std::move(tex_coords)));
+            new_mesh->parts(std::move(parts));
             m_meshes.emplace(file, std::move(new_mesh));
+            auto&& records = m_materials[file].records;
+            records.clear();
+            for (auto&& m : materials) {
+                records.push_back({glm::make_vec3(m.ambient), m.shininess, glm::make_vec3(m.diffuse), 0.0f,
+                                   glm::make_vec3(m.specular), 0.0f});
+            }
+            m_materials_dirty = true;
             break; // TODO for now, only load and draw the first mesh(shape)
         }
         return true;
@@ -352,21 +403,28 @@ Sandbox::aux_import_geometry(const ImportedFile& file)
 bool
 Sandbox::aux_import_dependency(const ImportedFile& path)
 {
-    // TODO import dependencies of shader (with in-source '#include')
-    throw unimplemented("Load dependencies");
+    // the included file may include something else now
+    aux_update_includes(path.path(), false);
+    auto&& dependents = m_includes.dependents(path.path());
+    aux_recompile([&dependents](const ImportedFile& file)
+                  { return dependents.find(file.path()) != dependents.end(); });
     return true;
 }
 
+template <typename Pred>
 void
-Sandbox::recompile_all()
+Sandbox::aux_recompile(Pred&& pred)
 {
     using Stage = OpenGL::ShaderStage;
     static const std::vector<Stage> stages = {Stage::Vertex, Stage::TessellationControl,
                                               Stage::TessellationEvaluation, Stage::Geometry,
                                               Stage::Fragment, Stage::Compute};
-    static auto recompile_it = [](ImportedProgram& imported, auto stage, auto usage)
+    auto&& recompile_it = [this, &pred](ImportedProgram& imported, auto stage, auto usage)
     {
-        imported = aux_compile(imported.file, stage, usage);
+        if (!imported.file.path().empty() && pred(imported.file)) {
+            Log::i("Recompiling {}", imported.file.path());
+            aux_compile(imported, imported.file, stage, usage);
+        }
     };
     for (auto stage : stages) {
         recompile_it(m_programs_user[underlying_cast(stage)], stage, ShaderUsage::User);
@@ -375,73 +433,225 @@ Sandbox::recompile_all()
     recompile_it(m_postprocess_frag, Stage::Fragment, ShaderUsage::Postprocess);
 }
 
-Sandbox::ImportedProgram
-Sandbox::aux_compile(const ImportedFile& file, OpenGL::ShaderStage stage, ShaderUsage usage)
+void
+Sandbox::recompile_all()
+{ aux_recompile([](const ImportedFile&) { return true; }); }
+
+void
+Sandbox::aux_compile(ImportedProgram& slot, const ImportedFile& file, OpenGL::ShaderStage stage, ShaderUsage usage)
 {
-    auto&& ex_source = file.fetch();
-    if (!ex_source) {
-        Log::e("Failed to read content of {}:\n\t{}", file.path(), ex_source.error());
-        return {file, OpenGL::Empty()};
-    }
     auto type = OpenGL::shader_stage_type(stage);
     auto&& name = OpenGL::shader_type_name(type);
-    auto& source = *ex_source;
+    Preprocessor preprocessor(m_sources);
+    preprocessor.define_all(options.defines);
     std::string label;
+    aux_cancel(slot);
+    slot.file = file; // even if failing, so that the file is compiled again once fixed
     switch (usage) {
         case ShaderUsage::User:
             label = "[user]" + name;
-            source = aux_preprocess_shader_source(source, {});
             break;
         case ShaderUsage::Background:
             if (stage != OpenGL::ShaderStage::Fragment) {
                 ERROR("Only fragment shader can be specified in background phase rendering");
-                return {file, OpenGL::Empty()};
+                return;
             }
             label = "[background]" + name;
-            source = aux_preprocess_shader_source(source, {"BACKGROUND"});
+            preprocessor.define("BACKGROUND");
             break;
         case ShaderUsage::Postprocess:
             if (stage != OpenGL::ShaderStage::Fragment) {
                 ERROR("Only fragment shader can be specified in postprocess phase rendering");
-                return {file, OpenGL::Empty()};
+                return;
             }
             label = "[postprocess]" + name;
-            source = aux_preprocess_shader_source(source, {"POSTPROCESS"});
+            preprocessor.define("POSTPROCESS");
             break;
         default:
             UNREACHABLE;
     }
-    auto program = OpenGL::Program(type, {source});
-    if (program.name() == 0) {
-        Log::e("Shader failed to compile: {}", program.get_info_log());
-        return {file, OpenGL::Empty()};
+    // files included don't depend on macros, so the last translation unit tells the key of this variant as well
+    auto&& last = m_translation_units.find(std::make_pair(file.path(), usage));
+    if (last != m_translation_units.end()) {
+        auto&& key = aux_translation_unit_key(last->second.preprocessed.files, preprocessor.defines_hash());
+        auto* resident_key = key ? m_variants.find(hash_combine(key, type)) : nullptr;
+        if (auto* resident = resident_key ? m_resident.find(*resident_key) : nullptr) {
+            aux_install(slot, file, *resident);
+            return;
+        }
+    }
+    auto&& unit = aux_preprocess(file.path(), usage, preprocessor);
+    if (!unit) {
+        Log::e("Failed to load {}: {}", file.path(), unit.error());
+        return;
+    }
+    auto&& preprocessed = (*unit)->preprocessed;
+    auto resident_key = hash_combine(hash64(preprocessed.source), type);
+    if ((*unit)->key) {
+        m_variants.insert(hash_combine((*unit)->key, type), resident_key);
+    }
+    if (auto* resident = m_resident.find(resident_key)) {
+        aux_install(slot, file, *resident);
+        return;
+    }
+    auto binary_key = m_binaries.key({{type, &preprocessed.source}});
+    auto program = std::make_shared<OpenGL::Program>(m_binaries.load(binary_key));
+    if (program->name() != 0) {
+        program->label(label);
+        m_binaries.load_introspection(binary_key, *program);
+        aux_keep_resident(resident_key, program);
+        aux_install(slot, file, std::move(program));
+        return;
+    }
+    m_pending.push_back({&slot, file, m_compiler.compile(type, preprocessed.source), std::move(label), resident_key,
+                         binary_key, preprocessed.files, preprocessed.lines});
+}
+
+void
+Sandbox::aux_keep_resident(std::uint64_t key, const Shared<OpenGL::Program>& program)
+{
+    // what drivers keep of a linked program is opaque; its binary is the closest measure
+    auto length = program->get(GL_PROGRAM_BINARY_LENGTH);
+    m_resident.insert(key, program, static_cast<std::size_t>(std::max(1, length)));
+}
+
+void
+Sandbox::aux_cancel(const ImportedProgram& slot)
+{
+    auto it = std::find_if(m_pending.begin(), m_pending.end(),
+                           [&slot](const PendingProgram& pending) { return pending.slot == &slot; });
+    if (it != m_pending.end()) {
+        m_compiler.cancel(it->ticket);
+        m_pending.erase(it);
+    }
+}
+
+void
+Sandbox::aux_install(ImportedProgram& slot, const ImportedFile& file, Shared<OpenGL::Program> program)
+{
+    Log::i("Shader {} installed from {}", program->label(), file.path());
+    if (slot.program && slot.program->name() != 0 && slot.program != program) {
+        aux_carry_over(*slot.program, *program);
+    }
+    slot.file = file;
+    slot.program = std::move(program);
+    if (&slot >= m_programs_user.data() && &slot < m_programs_user.data() + m_programs_user.size()) {
+        m_monolithic_dirty = true;
+    }
+}
+
+void
+Sandbox::aux_carry_over(const OpenGL::Program& old_program, const OpenGL::Program& new_program)
+{
+    auto&& before = old_program.interfaces().lock();
+    auto&& after = new_program.interfaces().lock();
+    auto uniforms = OpenGL::diff(before->uniform(), after->uniform());
+    auto inputs = OpenGL::diff(before->input(), after->input());
+    auto carried = OpenGL::carry_uniforms(old_program, new_program, uniforms);
+    if (!uniforms.empty() || !inputs.empty()) {
+        Log::i("Shader {} reloaded: uniforms {}, inputs {}; {} uniform values kept", new_program.label(),
+               uniforms.summary(), inputs.summary(), carried);
     }
-    program.label(label);
-    return {file, std::move(program)};
+}
+
+void
+Sandbox::update()
+{
+    for (auto it = m_pending.begin(); it != m_pending.end();) {
+        auto&& program = m_compiler.poll(it->ticket);
+        if (!program) {
+            ++it;
+            continue;
+        }
+        if (program->name() == 0) {
+            Log::e("Shader failed to compile: {}", it->lines.rewrite(program->get_info_log(), it->files));
+        } else {
+            m_binaries.store(it->binary_key, *program);
+            program->label(it->label);
+            m_binaries.store_introspection(it->binary_key, *program);
+            aux_keep_resident(it->resident_key, program);
+            aux_install(*it->slot, it->file, std::move(program));
+        }
+        it = m_pending.erase(it);
+    }
+    if (m_monolithic_ticket != 0) {
+        if (auto&& program = m_compiler.poll(m_monolithic_ticket)) {
+            m_monolithic_ticket = 0;
+            if (program->name() == 0) {
+                Log::e("Monolithic program failed to link: {}", program->get_info_log());
+            } else {
+                m_binaries.store(m_monolithic_binary_key, *program);
+                program->label("[user]monolithic");
+                m_binaries.store_introspection(m_monolithic_binary_key, *program);
+                aux_keep_resident(m_monolithic_resident_key, program);
+                m_monolithic = std::move(program);
+            }
+        }
+    }
+    aux_update_builtins();
+    aux_update_lights();
+}
+
+expected<const Sandbox::TranslationUnit*, std::string>
+Sandbox::aux_preprocess(const FS::path& file, ShaderUsage usage, const Preprocessor& preprocessor)
+{
+    auto&& defines_hash = preprocessor.defines_hash();
+    auto key = std::make_pair(file, usage);
+    auto it = m_translation_units.find(key);
+    if (it != m_translation_units.end() && it->second.key != 0 &&
+        it->second.key == aux_translation_unit_key(it->second.preprocessed.files, defines_hash)) {
+        return &it->second;
+    }
+    auto&& preprocessed = preprocessor.process(file);
+    if (!preprocessed) {
+        if (it != m_translation_units.end()) {
+            m_translation_units.erase(it);
+        }
+        return make_unexpected(preprocessed.error());
+    }
+    auto& unit = m_translation_units[key];
+    unit.key = aux_translation_unit_key(preprocessed->files, defines_hash);
+    unit.preprocessed = std::move(*preprocessed);
+    return &unit;
+}
+
+std::uint64_t
+Sandbox::aux_translation_unit_key(const FS::FileList& files, std::uint64_t defines_hash)
+{
+    std::uint64_t key = defines_hash;
+    for (auto&& path : files) {
+        auto&& file = m_sources.get(path);
+        if (!file) {
+            return 0;
+        }
+        key = hash_combine(key, (*file)->hash);
+    }
+    return key;
 }
 
 void
 Sandbox::render_background()
 {
     // if postprocessing is enabled, render into custom framebuffer rather than the default one.
-    if (m_postprocess_frag.program.name() != 0) {
+    if (m_postprocess_frag.name() != 0) {
         m_scene.unbind(GL_FRAMEBUFFER);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); // clear default buffer
         m_scene.bind(GL_FRAMEBUFFER);
     }
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); // clear buffer currently drawing into
-    if (m_background_frag.program.name() == 0) {
+    if (m_background_frag.name() == 0) {
         return;
     }
-    m_pipeline_internal.use_stage(m_background_frag.program, GL_FRAGMENT_SHADER_BIT);
-    m_pipeline_internal.use_stage(m_background_vert, GL_VERTEX_SHADER_BIT);
-    if (m_pipeline_internal.valid()) {
-        m_pipeline_internal.bind();
+    m_pipeline_background.use_stage(m_background_frag.program, GL_FRAGMENT_SHADER_BIT);
+    m_pipeline_background.use_stage(m_background_vert, GL_VERTEX_SHADER_BIT);
+    if (m_pipeline_background.valid()) {
+        m_pipeline_background.bind();
+        aux_apply_subroutines(m_background_frag, OpenGL::ShaderStage::Fragment);
         m_vao_internal.bind();
-        aux_assign_uniforms(m_background_frag.program, camera);
+        aux_assign_uniforms(*m_background_frag.program, m_background_frag.uniforms);
         glDrawArrays(GL_TRIANGLES, 0, 6);
     } else {
-        ONCE_PER(ERROR("Background shader program invalid."), 60);
+        ONCE_PER(ERROR("Background shader program invalid: {}", m_pipeline_background.info_log()), 60);
     }
 }
 
@@ -450,71 +660,207 @@ Sandbox::render()
 {
     // this could either render into post-processing FBO or the default framebuffer depending on if m_scene is bound in
     // render_background().
+    aux_render_user(options.opengl.monolithic);
+}
+
+void
+Sandbox::aux_render_user(bool monolithic)
+{
     using Stage = OpenGL::ShaderStage;
+    auto&& vertex = m_programs_user[underlying_cast(Stage::Vertex)];
+    // TODO maybe provide a default one?
+    if (vertex.name() == 0) {
+        ONCE_PER(Log::e("No vertex shader found."), 60);
+        return;
+    } else if (m_programs_user[underlying_cast(Stage::Fragment)].name() == 0) {
+        ONCE_PER(Log::e("No fragment shader found."), 60);
+        return;
+    };
+    // the separable pipeline is drawn with until the monolithic program is linked
+    if (monolithic && aux_link_monolithic()) {
+        OpenGL::Program::Use(*m_monolithic);
+        for (std::size_t i = 0; i < OpenGL::MaxShaderStage; ++i) {
+            m_monolithic_subroutines[i].apply(*m_monolithic, static_cast<Stage>(i), m_subroutines[i]);
+        }
+        aux_assign_uniforms(*m_monolithic, m_monolithic_uniforms);
+        aux_draw_meshes(*m_monolithic, m_monolithic_uniforms);
+        glUseProgram(0); // or it overrides program pipelines bound later
+        return;
+    }
     for (auto stage : {Stage::Vertex, Stage::TessellationControl, Stage::TessellationEvaluation, Stage::Geometry,
                        Stage::Fragment, Stage::Compute}) {
-        auto&&[_, program] = m_programs_user[underlying_cast(stage)];
-        if (program.name()) {
-            m_pipeline_user.use_stage(program, OpenGL::shader_stage_bit(stage));
-            aux_assign_uniforms(program, camera);
+        auto&& imported = m_programs_user[underlying_cast(stage)];
+        m_pipeline_user.use_stage(imported.program, OpenGL::shader_stage_bit(stage));
+        if (imported.name()) {
+            aux_assign_uniforms(*imported.program, imported.uniforms);
         }
     }
     if (m_pipeline_user.valid()) {
         m_pipeline_user.bind();
-        const auto&[_, vertex_shader] = m_programs_user[underlying_cast(Stage::Vertex)];
-        // TODO maybe provide a default one?
-        if (vertex_shader.name() == 0) {
-            ONCE_PER(Log::e("No vertex shader found."), 60);
-            return;
-        } else if (m_programs_user[underlying_cast(Stage::Fragment)].program.name() == 0) {
-            ONCE_PER(Log::e("No fragment shader found."), 60);
-            return;
-        };
-        auto&& uniforms = vertex_shader.interfaces().lock()->uniform();
-        // TODO material and illumination is per-mesh at least.
-        GLuint name = vertex_shader.name();
-        uniforms.assign(name, "L.pos", camera.world_to_view({4.0f, 10.0f, 4.0f}));
-        uniforms.assign(name, "L.la", 0.15f, 0.15f, 0.05f);
-        uniforms.assign(name, "L.ld", 0.8f, 0.8f, 0.03f);
-        uniforms.assign(name, "L.ls", 0.8f, 0.8f, 0.03f);
-        uniforms.assign(name, "M.ka", 0.5f, 0.5f, 1.0f);
-        uniforms.assign(name, "M.kd", 0.7f, 0.7f, 0.7f);
-        uniforms.assign(name, "M.ks", 0.5f, 0.5f, 0.5f);
-        uniforms.assign(name, "M.shininess", 16.0f);
-        for (auto&&[file, mesh] : m_meshes) {
-            mesh->draw(name);
+        for (std::size_t i = 0; i < OpenGL::MaxShaderStage; ++i) {
+            aux_apply_subroutines(m_programs_user[i], static_cast<Stage>(i));
+        }
+        aux_draw_meshes(*vertex.program, vertex.uniforms);
+    } else {
+        ONCE_PER(Log::e("User program pipeline invalid: {}", m_pipeline_user.info_log()), 60);
+    }
+}
+
+const Sandbox::MaterialBlock Sandbox::DefaultMaterial{{0.5f, 0.5f, 1.0f}, 16.0f, {0.7f, 0.7f, 0.7f}, 0.0f,
+                                                      {0.5f, 0.5f, 0.5f}, 0.0f};
+
+void
+Sandbox::aux_draw_meshes(const OpenGL::Program& program, BuiltinUniforms& uniforms)
+{
+    GLuint name = program.name();
+    aux_upload_materials();
+    aux_check_blocks(program, uniforms);
+    if (!uniforms.lights_block && !m_lights.empty()) {
+        auto&& light = m_lights.front();
+        uniforms.L_pos.assign(program, light.pos);
+        uniforms.L_la.assign(program, light.la);
+        uniforms.L_ld.assign(program, light.ld);
+        uniforms.L_ls.assign(program, light.ls);
+    }
+    for (auto&&[file, mesh] : m_meshes) {
+        auto it = m_materials.find(file);
+        auto* materials = it == m_materials.end() ? nullptr : &it->second;
+        mesh->draw(name, [this, &program, &uniforms, materials](GLint material)
+        {
+            // bound even if program declares no block, as other stages of the pipeline may
+            GLint record = material < 0 || !materials ? 0 : materials->base + material;
+            glBindBufferRange(GL_UNIFORM_BUFFER, MaterialBinding, m_material_buffer.name(), record * m_material_stride,
+                              sizeof(MaterialBlock));
+            if (!uniforms.material_block) {
+                auto&& m = record == 0 ? DefaultMaterial : materials->records[material];
+                uniforms.M_ka.assign(program, m.ka);
+                uniforms.M_kd.assign(program, m.kd);
+                uniforms.M_ks.assign(program, m.ks);
+                uniforms.M_shininess.assign(program, m.shininess);
+            }
+        });
+    }
+}
+
+bool
+Sandbox::aux_link_monolithic()
+{
+    if (!m_monolithic_dirty) {
+        return m_monolithic != nullptr;
+    }
+    m_monolithic_dirty = false;
+    m_monolithic = nullptr;
+    if (m_monolithic_ticket != 0) {
+        m_compiler.cancel(m_monolithic_ticket);
+        m_monolithic_ticket = 0;
+    }
+    // stages are preprocessed anew rather than taken from their separable programs, which might be resident variants
+    Preprocessor preprocessor(m_sources);
+    preprocessor.define_all(options.defines);
+    std::vector<std::pair<GLenum, std::string>> stages;
+    std::uint64_t key = hash64("monolithic");
+    for (std::size_t i = 0; i < m_programs_user.size(); ++i) {
+        auto&& imported = m_programs_user[i];
+        if (imported.name() == 0) {
+            continue;
+        }
+        auto type = OpenGL::shader_stage_type(static_cast<OpenGL::ShaderStage>(i));
+        auto&& unit = aux_preprocess(imported.file.path(), ShaderUsage::User, preprocessor);
+        if (!unit) {
+            Log::e("Failed to load {}: {}", imported.file.path(), unit.error());
+            return false;
+        }
+        stages.emplace_back(type, (*unit)->preprocessed.source);
+        key = hash_combine(key, hash_combine(hash64(stages.back().second), type));
+    }
+    if (auto* resident = m_resident.find(key)) {
+        m_monolithic = *resident;
+        return true;
+    }
+    std::vector<OpenGL::BinaryCache::Stage> binary_stages;
+    for (auto&&[type, source] : stages) {
+        binary_stages.emplace_back(type, &source);
+    }
+    auto binary_key = m_binaries.key(binary_stages, false);
+    auto program = std::make_shared<OpenGL::Program>(m_binaries.load(binary_key, false));
+    if (program->name() != 0) {
+        program->label("[user]monolithic");
+        m_binaries.load_introspection(binary_key, *program);
+        aux_keep_resident(key, program);
+        m_monolithic = std::move(program);
+        return true;
+    }
+    // linked in the background by m_compiler; see update()
+    m_monolithic_ticket = m_compiler.link(std::move(stages));
+    m_monolithic_resident_key = key;
+    m_monolithic_binary_key = binary_key;
+    return false;
+}
+
+std::vector<Sandbox::Timing>
+Sandbox::benchmark(unsigned frames)
+{
+    std::vector<Timing> ret;
+    if (frames == 0) {
+        return ret;
+    }
+    std::vector<GLuint> queries(frames);
+    glGenQueries(static_cast<GLsizei>(frames), queries.data());
+    for (bool monolithic : {false, true}) {
+        for (auto query : queries) {
+            glBeginQuery(GL_TIME_ELAPSED, query);
+            aux_render_user(monolithic);
+            glEndQuery(GL_TIME_ELAPSED);
+        }
+        if (monolithic && !m_monolithic) {
+            continue;
+        }
+        std::vector<double> times;
+        for (auto query : queries) {
+            GLuint64 elapsed = 0;
+            glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed); // waits for the GPU
+            times.push_back(static_cast<double>(elapsed) / 1.0e6);
+        }
+        std::sort(times.begin(), times.end());
+        double sum = 0.0;
+        for (auto time : times) {
+            sum += time;
         }
+        ret.push_back({monolithic ? "monolithic" : "separable", frames, times.front(), times[times.size() / 2],
+                       sum / times.size()});
     }
+    glDeleteQueries(static_cast<GLsizei>(frames), queries.data());
+    return ret;
 }
 
 void
 Sandbox::render_postprocess()
 {
-    if (m_postprocess_frag.program.name() == 0) {
+    if (m_postprocess_frag.name() == 0) {
         return;
     }
     m_scene.unbind(GL_FRAMEBUFFER); // we should rendering into default framebuffer
-    m_pipeline_internal.use_stage(m_postprocess_frag.program, GL_FRAGMENT_SHADER_BIT);
-    m_pipeline_internal.use_stage(m_postprocess_vert, GL_VERTEX_SHADER_BIT);
-    if (m_pipeline_internal.valid()) {
-        m_pipeline_internal.bind();
+    m_pipeline_postprocess.use_stage(m_postprocess_frag.program, GL_FRAGMENT_SHADER_BIT);
+    m_pipeline_postprocess.use_stage(m_postprocess_vert, GL_VERTEX_SHADER_BIT);
+    if (m_pipeline_postprocess.valid()) {
+        m_pipeline_postprocess.bind();
+        aux_apply_subroutines(m_postprocess_frag, OpenGL::ShaderStage::Fragment);
         m_vao_internal.bind();
-        auto&& uniforms = aux_assign_uniforms(m_postprocess_frag.program, camera);
-        auto name = m_postprocess_frag.program.name();
-        uniforms.assign(name, "u_scene", 0);
-        uniforms.assign(name, "u_depth", 1);
+        aux_assign_uniforms(*m_postprocess_frag.program, m_postprocess_frag.uniforms);
+        m_u_scene.assign(*m_postprocess_frag.program, 0);
+        m_u_depth.assign(*m_postprocess_frag.program, 1);
         glDrawArrays(GL_TRIANGLES, 0, 6);
     } else {
-        ONCE_PER(ERROR("Postprocessing shader invalid"), 60);
+        ONCE_PER(ERROR("Postprocessing shader invalid: {}", m_pipeline_postprocess.info_log()), 60);
     }
 }
 
 void
 Sandbox::render_debug()
 {
-    m_pipeline_internal.use_stage(m_debug_axes, GL_ALL_SHADER_BITS);
-    assert(m_pipeline_internal.valid());
-    m_pipeline_internal.bind();
+    m_pipeline_debug.use_stage(m_debug_axes, GL_ALL_SHADER_BITS);
+    assert(m_pipeline_debug.valid());
+    m_pipeline_debug.bind();
     auto&& pvm = camera.projection_world();
     glProgramUniformMatrix4fv(m_debug_axes.name(), 0, 1, GL_FALSE, glm::value_ptr(pvm));
     glProgramUniform1f(m_debug_axes.name(), 1, 1.0f);
@@ -526,50 +872,314 @@ std::vector<std::pair<GLuint, std::string>>
 Sandbox::programs()
 {
     std::vector<std::pair<GLuint, std::string>> ret;
-    for (auto&&[_, program] : m_programs_user) {
-        if (program.name() != 0) {
-            ret.emplace_back(program.name(), program.label());
+    for (auto&& imported : m_programs_user) {
+        if (imported.name() != 0) {
+            ret.emplace_back(imported.name(), imported.program->label());
         }
     }
-    auto& background_frag = m_background_frag.program;
-    if (background_frag.name() != 0) {
-        ret.emplace_back(background_frag.name(), background_frag.label());
+    if (m_background_frag.name() != 0) {
+        ret.emplace_back(m_background_frag.name(), m_background_frag.program->label());
     }
     return ret;
 }
 
-const OpenGL::ProgramInterface<OpenGL::Uniform>&
-Sandbox::aux_assign_uniforms(const OpenGL::Program& program, const Scene::Camera& camera)
+std::vector<Shared<OpenGL::Program>>
+Sandbox::stage_programs(OpenGL::ShaderStage stage)
+{
+    std::vector<Shared<OpenGL::Program>> ret;
+    auto&& imported = m_programs_user[underlying_cast(stage)];
+    if (imported.name() != 0) {
+        ret.push_back(imported.program);
+    }
+    if (stage == OpenGL::ShaderStage::Fragment) {
+        for (auto* frag : {&m_background_frag, &m_postprocess_frag}) {
+            if (frag->name() != 0) {
+                ret.push_back(frag->program);
+            }
+        }
+    }
+    return ret;
+}
+
+expected<void, std::string>
+Sandbox::select_subroutine(OpenGL::ShaderStage stage, const std::string& uniform, const std::string& subroutine)
+{
+    bool declared = false;
+    for (auto&& program : stage_programs(stage)) {
+        auto&& introspector = program->interfaces().lock();
+        auto compatible = OpenGL::visit_subroutine_uniforms(*introspector, stage, [&](auto&& interface)
+        {
+            auto* sub_uniform = interface.find(uniform);
+            if (!sub_uniform) {
+                return false;
+            }
+            declared = true;
+            return std::any_of(sub_uniform->subroutines.begin(), sub_uniform->subroutines.end(),
+                               [&subroutine](auto&& s)
+                               { return s.name == subroutine; });
+        });
+        if (compatible) {
+            m_subroutines[underlying_cast(stage)].select(uniform, subroutine);
+            return {};
+        }
+    }
+    auto&& type = OpenGL::shader_type_name(OpenGL::shader_stage_type(stage));
+    if (!declared) {
+        return make_unexpected(fmt::format("No {} declares subroutine uniform {}", type, uniform));
+    }
+    return make_unexpected(fmt::format("Subroutine uniform {} of {} takes no subroutine {}", uniform, type,
+                                       subroutine));
+}
+
+void
+Sandbox::deselect_subroutine(OpenGL::ShaderStage stage, const std::string& uniform)
+{
+    auto&& selection = m_subroutines[underlying_cast(stage)];
+    if (uniform.empty()) {
+        selection.clear();
+    } else {
+        selection.deselect(uniform);
+    }
+}
+
+void
+Sandbox::aux_apply_subroutines(ImportedProgram& imported, OpenGL::ShaderStage stage)
+{
+    if (imported.name() != 0) {
+        imported.subroutines.apply(*imported.program, stage, m_subroutines[underlying_cast(stage)]);
+    }
+}
+
+void
+Sandbox::aux_update_builtins()
 {
-    auto&& uni = program.interfaces().lock()->uniform();
-    GLuint name = program.name();
     auto&& vp = main_window->viewport();
     auto&& mpos = main_window->mouse_position();
     mpos.y = vp.w - mpos.y; // XXX
-    uni.assign(name, "u_viewport", vp);
-    uni.assign(name, "u_fbsize", main_window->frame_buffer_size());
-    uni.assign(name, "u_mpos", mpos);
-    uni.assign(name, "u_time", static_cast<float>(glfwGetTime()));
-    uni.assign(name, "u_camera", camera.transform().position);
-    uni.assign(name, "u_clip", camera.clip());
-    uni.assign(name, "PVM", camera.projection_world());
-    uni.assign(name, "PV", camera.projection_view());
-    uni.assign(name, "VM", camera.view_world());
-    uni.assign(name, "NM", camera.normal_matrix());
-    return uni;
+    m_builtins.u_viewport = vp;
+    m_builtins.u_fbsize = main_window->frame_buffer_size();
+    m_builtins.u_mpos = mpos;
+    m_builtins.u_camera = camera.transform().position;
+    m_builtins.u_time = static_cast<float>(glfwGetTime());
+    m_builtins.u_clip = camera.clip();
+    m_builtins.PVM = camera.projection_world();
+    m_builtins.PV = camera.projection_view();
+    m_builtins.VM = camera.view_world();
+    m_builtins.NM = glm::mat3x4(camera.normal_matrix());
+    m_builtin_ring.write(m_builtins);
+    m_builtin_ring.bind(BuiltinBinding);
+}
+
+void
+Sandbox::aux_update_lights()
+{
+    // TODO illumination is per-scene at least.
+    m_lights.assign(1, {camera.world_to_view({4.0f, 10.0f, 4.0f}), 0.0f, {0.15f, 0.15f, 0.05f}, 0.0f,
+                        {0.8f, 0.8f, 0.03f}, 0.0f, {0.8f, 0.8f, 0.03f}, 0.0f});
+    auto n_lights = std::min(m_lights.size(), MaxLights);
+    // the slot written next is one the GPU is done reading
+    auto* header = static_cast<LightsHeader*>(m_lights_buffer.next());
+    header->n_lights = static_cast<GLuint>(n_lights);
+    std::memcpy(header + 1, m_lights.data(), n_lights * sizeof(LightRecord));
+    m_lights_buffer.flush(0, static_cast<GLsizeiptr>(sizeof(LightsHeader) + n_lights * sizeof(LightRecord)));
+    m_lights_buffer.bind(LightsBinding);
+}
+
+namespace {
+
+/// A member of a built-in block as std140 or std430 lays it out.
+struct BlockMember {
+    std::string_view name;
+    GLenum type;
+    std::size_t offset;
+    /// Stride of the top level array the member is (in), 0 if none; only checked of buffer blocks.
+    std::size_t top_level_stride = 0;
+};
+
+/// Whether @p variable, a member of block @p name of @p program, is laid out as one of @p members.
+template <typename Variable, std::size_t N>
+bool
+aux_check_member(const OpenGL::Program& program, std::string_view name, const Variable& variable,
+                 const BlockMember (& members)[N])
+{
+    auto member = std::find_if(std::begin(members), std::end(members),
+                               [&variable](const BlockMember& m) { return m.name == variable.name; });
+    bool matches = member != std::end(members) && static_cast<GLenum>(variable.type) == member->type &&
+                   static_cast<std::size_t>(variable.offset) == member->offset && !variable.row_major &&
+                   (variable.mstride <= 0 || variable.mstride == sizeof(glm::vec4));
+    if constexpr (std::is_same_v<Variable, OpenGL::BufferVariable>) {
+        matches = matches && static_cast<std::size_t>(variable.top_level_astride) == member->top_level_stride;
+    }
+    if (!matches) {
+        Log::w("Program [{}]\"{}\": block {} doesn't match the built-in layout at {}; see README.",
+               program.name(), program.label(), name, variable.name);
+    }
+    return matches;
+}
+
+/// @brief Check block @p name of @p program, if declared, against @p members laid out in @p size bytes, and bind it
+/// to @p binding if it matches.
+/// @return Whether @p program declares the block as laid out; if not, its members are to be assigned otherwise.
+template <std::size_t N>
+bool
+aux_check_block(const OpenGL::Program& program, std::string_view name, const BlockMember (& members)[N],
+                std::size_t size, GLuint binding)
+{
+    auto&& introspector = program.interfaces().lock();
+    auto block = introspector->uniform_block().find(name);
+    if (!block) {
+        return false;
+    }
+    if (static_cast<std::size_t>(block->size) > size) {
+        Log::w("Program [{}]\"{}\": block {} takes {} bytes, more than the built-in {}; see README.",
+               program.name(), program.label(), name, block->size, size);
+        return false;
+    }
+    for (auto uniform : block->uniforms) {
+        if (!aux_check_member(program, name, *uniform, members)) {
+            return false;
+        }
+    }
+    if (static_cast<GLuint>(block->binding) != binding) {
+        glUniformBlockBinding(program.name(), block->index, binding);
+    }
+    return true;
+}
+
+/// @brief Check buffer block @p name of @p program, if declared, against @p members laid out in at most @p size
+/// bytes, and bind it to @p binding if it matches.
+/// @return Whether @p program declares the block as laid out.
+template <std::size_t N>
+bool
+aux_check_storage_block(const OpenGL::Program& program, std::string_view name, const BlockMember (& members)[N],
+                        std::size_t size, GLuint binding)
+{
+    auto&& introspector = program.interfaces().lock();
+    auto block = introspector->shader_storage_block().find(name);
+    if (!block) {
+        return false;
+    }
+    if (static_cast<std::size_t>(block->size) > size) {
+        Log::w("Program [{}]\"{}\": block {} takes at least {} bytes, more than the built-in {}; see README.",
+               program.name(), program.label(), name, block->size, size);
+        return false;
+    }
+    for (auto variable : block->variables) {
+        if (!aux_check_member(program, name, *variable, members)) {
+            return false;
+        }
+    }
+    if (static_cast<GLuint>(block->binding) != binding) {
+        glShaderStorageBlockBinding(program.name(), block->index, binding);
+    }
+    return true;
+}
+
+} // namespace
+
+void
+Sandbox::aux_check_blocks(const OpenGL::Program& program, BuiltinUniforms& uniforms)
+{
+    if (uniforms.block_program == program.name() && !uniforms.block_introspector.expired()) {
+        return;
+    }
+    static const BlockMember builtin_members[] = {
+            {"u_viewport", GL_INT_VEC4,   offsetof(BuiltinBlock, u_viewport)},
+            {"u_fbsize",   GL_INT_VEC2,   offsetof(BuiltinBlock, u_fbsize)},
+            {"u_mpos",     GL_INT_VEC2,   offsetof(BuiltinBlock, u_mpos)},
+            {"u_camera",   GL_FLOAT_VEC3, offsetof(BuiltinBlock, u_camera)},
+            {"u_time",     GL_FLOAT,      offsetof(BuiltinBlock, u_time)},
+            {"u_clip",     GL_FLOAT_VEC2, offsetof(BuiltinBlock, u_clip)},
+            {"PVM",        GL_FLOAT_MAT4, offsetof(BuiltinBlock, PVM)},
+            {"PV",         GL_FLOAT_MAT4, offsetof(BuiltinBlock, PV)},
+            {"VM",         GL_FLOAT_MAT4, offsetof(BuiltinBlock, VM)},
+            {"NM",         GL_FLOAT_MAT3, offsetof(BuiltinBlock, NM)},
+    };
+    // members of blocks with an instance name are named after the block
+    static const BlockMember material_members[] = {
+            {"Material.ka",        GL_FLOAT_VEC3, offsetof(MaterialBlock, ka)},
+            {"Material.shininess", GL_FLOAT,      offsetof(MaterialBlock, shininess)},
+            {"Material.kd",        GL_FLOAT_VEC3, offsetof(MaterialBlock, kd)},
+            {"Material.ks",        GL_FLOAT_VEC3, offsetof(MaterialBlock, ks)},
+    };
+    uniforms.block_program = program.name();
+    uniforms.block_introspector = program.interfaces();
+    uniforms.builtin_block = aux_check_block(program, "Builtins", builtin_members, sizeof(BuiltinBlock),
+                                             BuiltinBinding);
+    uniforms.material_block = aux_check_block(program, "Material", material_members, sizeof(MaterialBlock),
+                                              MaterialBinding);
+    // elements of arrays of structures are named after their first element
+    static const BlockMember lights_members[] = {
+            {"n_lights",      GL_UNSIGNED_INT, offsetof(LightsHeader, n_lights)},
+            {"lights[0].pos", GL_FLOAT_VEC3,   sizeof(LightsHeader) + offsetof(LightRecord, pos), sizeof(LightRecord)},
+            {"lights[0].la",  GL_FLOAT_VEC3,   sizeof(LightsHeader) + offsetof(LightRecord, la),  sizeof(LightRecord)},
+            {"lights[0].ld",  GL_FLOAT_VEC3,   sizeof(LightsHeader) + offsetof(LightRecord, ld),  sizeof(LightRecord)},
+            {"lights[0].ls",  GL_FLOAT_VEC3,   sizeof(LightsHeader) + offsetof(LightRecord, ls),  sizeof(LightRecord)},
+    };
+    uniforms.lights_block = aux_check_storage_block(program, "Lights", lights_members,
+                                                    sizeof(LightsHeader) + MaxLights * sizeof(LightRecord),
+                                                    LightsBinding);
+}
+
+void
+Sandbox::aux_assign_uniforms(const OpenGL::Program& program, BuiltinUniforms& uniforms)
+{
+    aux_check_blocks(program, uniforms);
+    if (uniforms.builtin_block) {
+        return;
+    }
+    uniforms.u_viewport.assign(program, m_builtins.u_viewport);
+    uniforms.u_fbsize.assign(program, m_builtins.u_fbsize);
+    uniforms.u_mpos.assign(program, m_builtins.u_mpos);
+    uniforms.u_time.assign(program, m_builtins.u_time);
+    uniforms.u_camera.assign(program, m_builtins.u_camera);
+    uniforms.u_clip.assign(program, m_builtins.u_clip);
+    uniforms.PVM.assign(program, m_builtins.PVM);
+    uniforms.PV.assign(program, m_builtins.PV);
+    uniforms.VM.assign(program, m_builtins.VM);
+    uniforms.NM.assign(program, glm::mat3(m_builtins.NM));
+}
+
+void
+Sandbox::aux_upload_materials()
+{
+    if (!m_materials_dirty) {
+        return;
+    }
+    m_materials_dirty = false;
+    GLint alignment = 1;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    alignment = std::max(alignment, 1);
+    m_material_stride = (static_cast<GLsizeiptr>(sizeof(MaterialBlock)) + alignment - 1) / alignment * alignment;
+    GLint n_records = 1;
+    for (auto&&[file, materials] : m_materials) {
+        materials.base = n_records;
+        n_records += static_cast<GLint>(materials.records.size());
+    }
+    std::vector<unsigned char> data(static_cast<std::size_t>(n_records * m_material_stride));
+    std::memcpy(data.data(), &DefaultMaterial, sizeof(MaterialBlock));
+    for (auto&&[file, materials] : m_materials) {
+        for (std::size_t i = 0; i < materials.records.size(); ++i) {
+            std::memcpy(data.data() + (materials.base + i) * m_material_stride, &materials.records[i],
+                        sizeof(MaterialBlock));
+        }
+    }
+    m_material_buffer.bind(GL_UNIFORM_BUFFER);
+    OpenGL::Buffer::Data(GL_UNIFORM_BUFFER, static_cast<GLsizeiptr>(data.size()), data.data(), GL_STATIC_DRAW);
 }
 
 void
 Sandbox::toggle_background()
 {
-    if (m_background_frag.program.name() == 0) {
+    if (m_background_frag.name() == 0) {
         if (m_background_frag.file.path().empty()) {
             Log::w("Background shader not yet specified; can not enable");
             return;
         }
-        m_background_frag = aux_compile(m_background_frag.file, OpenGL::ShaderStage::Fragment, ShaderUsage::Background);
+        aux_compile(m_background_frag, m_background_frag.file, OpenGL::ShaderStage::Fragment, ShaderUsage::Background);
     } else {
-        m_background_frag.program = OpenGL::Empty();
+        aux_cancel(m_background_frag);
+        m_background_frag.program = nullptr;
     }
 }
 
@@ -608,15 +1218,16 @@ Sandbox::aux_allocate_framebuffer_texture(glm::ivec2 fbsize)
 void
 Sandbox::toggle_postprocess()
 {
-    if (m_postprocess_frag.program.name() == 0) {
+    if (m_postprocess_frag.name() == 0) {
         if (m_postprocess_frag.file.path().empty()) {
             Log::w("Postprocessing shader not yet specified, can not enable");
             return;
         }
-        m_postprocess_frag =
-                aux_compile(m_postprocess_frag.file, OpenGL::ShaderStage::Fragment, ShaderUsage::Postprocess);
+        aux_compile(m_postprocess_frag, m_postprocess_frag.file, OpenGL::ShaderStage::Fragment,
+                    ShaderUsage::Postprocess);
     } else {
-        m_postprocess_frag.program = OpenGL::Empty();
+        aux_cancel(m_postprocess_frag);
+        m_postprocess_frag.program = nullptr;
     }
 }
 
@@ -0,0 +1,102 @@
+/**
+ * @File Hash.cpp
+ * @author Zhen Luo 461652354@qq.com
+ */
+#include <Utility/Hash.hpp>
+#include <cstring>
+
+
+namespace {
+
+constexpr std::uint64_t Prime1 = 0x9E3779B185EBCA87ull;
+constexpr std::uint64_t Prime2 = 0xC2B2AE3D27D4EB4Full;
+constexpr std::uint64_t Prime3 = 0x165667B19E3779F9ull;
+constexpr std::uint64_t Prime4 = 0x85EBCA77C2B2AE63ull;
+constexpr std::uint64_t Prime5 = 0x27D4EB2F165667C5ull;
+
+inline std::uint64_t
+rotl(std::uint64_t x, int r)
+{ return (x << r) | (x >> (64 - r)); }
+
+// XXX assumes little endian, which is the case for every platform we build on.
+inline std::uint64_t
+read64(const unsigned char* p)
+{
+    std::uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline std::uint32_t
+read32(const unsigned char* p)
+{
+    std::uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline std::uint64_t
+round(std::uint64_t acc, std::uint64_t input)
+{
+    acc += input * Prime2;
+    acc = rotl(acc, 31);
+    return acc * Prime1;
+}
+
+inline std::uint64_t
+merge_round(std::uint64_t acc, std::uint64_t val)
+{
+    acc ^= round(0, val);
+    return acc * Prime1 + Prime4;
+}
+
+} // namespace
+
+std::uint64_t
+hash64(const void* data, std::size_t length, std::uint64_t seed) noexcept
+{
+    auto* p = static_cast<const unsigned char*>(data);
+    const auto* const end = p + length;
+    std::uint64_t h;
+    if (length >= 32) {
+        const auto* const limit = end - 32;
+        std::uint64_t v1 = seed + Prime1 + Prime2;
+        std::uint64_t v2 = seed + Prime2;
+        std::uint64_t v3 = seed;
+        std::uint64_t v4 = seed - Prime1;
+        do {
+            v1 = round(v1, read64(p));
+            v2 = round(v2, read64(p + 8));
+            v3 = round(v3, read64(p + 16));
+            v4 = round(v4, read64(p + 24));
+            p += 32;
+        } while (p <= limit);
+        h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        h = merge_round(h, v1);
+        h = merge_round(h, v2);
+        h = merge_round(h, v3);
+        h = merge_round(h, v4);
+    } else {
+        h = seed + Prime5;
+    }
+    h += static_cast<std::uint64_t>(length);
+    for (; p + 8 <= end; p += 8) {
+        h ^= round(0, read64(p));
+        h = rotl(h, 27) * Prime1 + Prime4;
+    }
+    if (p + 4 <= end) {
+        h ^= static_cast<std::uint64_t>(read32(p)) * Prime1;
+        h = rotl(h, 23) * Prime2 + Prime3;
+        p += 4;
+    }
+    for (; p < end; ++p) {
+        h ^= (*p) * Prime5;
+        h = rotl(h, 11) * Prime1;
+    }
+    h ^= h >> 33;
+    h *= Prime2;
+    h ^= h >> 29;
+    h *= Prime3;
+    h ^= h >> 32;
+    return h;
+}
@@ -0,0 +1,163 @@
+/**
+ * @File Validator.cpp
+ * @author Zhen Luo 461652354@qq.com
+ */
+#include <Validator.hpp>
+#include <Options.hpp>
+#include <Preprocessor.hpp>
+#include <OpenGL/Constants.hpp>
+#include <OpenGL/Headless.hpp>
+#include <OpenGL/Object/Shader.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double
+elapsed_ms(Clock::time_point since)
+{ return std::chrono::duration<double, std::milli>(Clock::now() - since).count(); }
+
+/// Write @p str as a JSON string literal.
+void
+write_json_string(std::ostream& out, const std::string& str)
+{
+    out << '"';
+    for (char c : str) {
+        switch (c) {
+            case '"':
+                out << "\\\"";
+                break;
+            case '\\':
+                out << "\\\\";
+                break;
+            case '\n':
+                out << "\\n";
+                break;
+            case '\t':
+                out << "\\t";
+                break;
+            case '\r':
+                out << "\\r";
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    out << fmt::format("\\u{:04x}", static_cast<unsigned>(c));
+                } else {
+                    out << c;
+                }
+        }
+    }
+    out << '"';
+}
+
+/// Shaders under @p directory, sorted by path.
+std::vector<ValidationResult>
+find_shaders(const FS::path& directory)
+{
+    std::vector<ValidationResult> ret;
+    std::error_code ec;
+    for (FS::details::recursive_directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec)) {
+        if (!FS::details::is_regular_file(it->status())) {
+            continue;
+        }
+        auto&& type = OpenGL::suffix_shader_type(it->path().extension());
+        if (type) {
+            ret.emplace_back();
+            ret.back().file = it->path();
+            ret.back().type = *type;
+        }
+    }
+    if (ec) {
+        Log::e("Failed to list {}: {}", directory, ec.message());
+    }
+    std::sort(ret.begin(), ret.end(),
+              [](const ValidationResult& a, const ValidationResult& b) { return a.file < b.file; });
+    return ret;
+}
+
+/// Preprocess and compile @p result.file on the current context.
+void
+validate_shader(ValidationResult& result)
+{
+    result.log.clear();
+    auto start = Clock::now();
+    Preprocessor preprocessor; // reading from disk, SourceFiles is not shared among threads
+    preprocessor.define_all(options.defines);
+    auto&& preprocessed = preprocessor.process(result.file);
+    result.preprocess_ms = elapsed_ms(start);
+    if (!preprocessed) {
+        result.log = preprocessed.error();
+        return;
+    }
+    start = Clock::now();
+    OpenGL::Shader shader(result.type);
+    shader.source(preprocessed->source);
+    glCompileShader(shader.name());
+    result.success = shader.get(GL_COMPILE_STATUS) == GL_TRUE; // waits for compiling to complete
+    result.compile_ms = elapsed_ms(start);
+    if (!result.success) {
+        result.log = preprocessed->lines.rewrite(shader.get_info_log().get(), preprocessed->files);
+    }
+}
+
+} // namespace
+
+int
+validate_shaders(const FS::path& directory, unsigned jobs, std::ostream& out)
+{
+    auto start = Clock::now();
+    auto&& results = find_shaders(directory);
+    for (auto&& result : results) {
+        result.log = "Not validated: no OpenGL context";
+    }
+    if (jobs == 0) {
+        jobs = std::max(1u, std::thread::hardware_concurrency());
+    }
+    jobs = static_cast<unsigned>(std::max<std::size_t>(1, std::min<std::size_t>(jobs, results.size())));
+    std::atomic_size_t next = 0;
+    std::atomic_bool context_failed = false;
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < jobs; ++i) {
+        workers.emplace_back([&]()
+                             {
+                                 OpenGL::HeadlessContext context;
+                                 if (!context.make_current()) {
+                                     if (!context_failed.exchange(true)) {
+                                         Log::e("Failed to create headless context: {}", context.error());
+                                     }
+                                     return;
+                                 }
+                                 for (auto n = next++; n < results.size(); n = next++) {
+                                     validate_shader(results[n]);
+                                 }
+                             });
+    }
+    for (auto&& worker : workers) {
+        worker.join();
+    }
+    std::size_t failed = 0;
+    for (auto&& result : results) {
+        if (!result.success) {
+            ++failed;
+        }
+        out << "{\"file\":";
+        write_json_string(out, result.file.string());
+        out << ",\"stage\":";
+        write_json_string(out, OpenGL::shader_type_name(result.type));
+        out << ",\"status\":\"" << (result.success ? "ok" : "error") << '"';
+        out << fmt::format(",\"preprocess_ms\":{:.3f},\"compile_ms\":{:.3f}", result.preprocess_ms,
+                           result.compile_ms);
+        out << ",\"log\":";
+        write_json_string(out, result.log);
+        out << "}\n";
+    }
+    out << fmt::format("{{\"summary\":{{\"files\":{},\"failed\":{},\"jobs\":{},\"wall_ms\":{:.3f}}}}}\n",
+                       results.size(), failed, jobs, elapsed_ms(start));
+    out.flush();
+    return failed == 0 && !context_failed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
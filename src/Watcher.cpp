@@ -3,10 +3,33 @@
  * @author Zhen Luo 461652354@qq.com
  */
 #include <Watcher.hpp>
+#include <Options.hpp>
 #include <Utility/Log.hpp>
+#include <Utility/Hash.hpp>
 #include <Utility/Enumeration.hpp>
+#include <OpenGL/Constants.hpp>
 #include <fstream>
+#include <algorithm>
+#include <cstring>
 
+#if defined(PLATFORM_LINUX)
+#include <sys/inotify.h>
+#include <sys/eventfd.h>
+#include <dirent.h>
+#include <poll.h>
+#include <unistd.h>
+#include <climits>
+#endif
+
+
+namespace {
+
+/// Whether @p path is strictly inside directory @p root, judging by path alone.
+bool
+is_inside(const std::string& root, const std::string& path)
+{ return path.size() > root.size() && path.compare(0, root.size(), root) == 0 && path[root.size()] == '/'; }
+
+} // namespace
 
 DEFINE_ENUMERATION_DATABASE(FileType) {
         {FileType::Shader,     "Shader"},
@@ -19,23 +42,10 @@ DEFINE_ENUMERATION_DATABASE(FileType) {
 Watcher::Watcher(const std::vector<ImportedFile>& to_watch) :
         m_thread([this]()
                  {
-                     std::vector<ImportedFile> to_erase;
-                     while (m_watching) {
-                         {
-                             std::lock_guard guard1(mutex_watching_files);
-                             for (auto&&[_, file] : m_watching_files) {
-                                 if (file.check_update()) {
-                                     std::lock_guard guard2(mutex_updated);
-                                     m_updated.insert(file);
-                                 } else {
-                                     to_erase.push_back(file);
-                                 }
-                             }
-                             for (auto&& file : to_erase) {
-                                 m_watching_files.erase({file.path(), file.tag});
-                             }
-                         }
-                         sleep_for_ms(250);
+                     if (m_inotify != -1) {
+                         aux_loop_inotify();
+                     } else {
+                         aux_loop_polling();
                      }
                  })
 {
@@ -44,6 +54,8 @@ Watcher::Watcher(const std::vector<ImportedFile>& to_watch) :
         if (file.path().empty()) {
             continue; // XXX non-existent path is emptied during preprocessing
         }
+        aux_watch_directory(file.path().parent_path());
+        m_tags.insert(file.tag);
         m_watching_files.emplace(std::make_pair(file.path(), file.tag), std::move(file));
     }
 }
@@ -51,7 +63,262 @@ Watcher::Watcher(const std::vector<ImportedFile>& to_watch) :
 Watcher::~Watcher()
 {
     m_watching = false;
+#if defined(PLATFORM_LINUX)
+    if (m_wakeup != -1) {
+        uint64_t one = 1;
+        if (write(m_wakeup, &one, sizeof(one)) != sizeof(one)) {
+            Log::e("Failed to wake up watcher thread: {}", std::strerror(errno));
+        }
+    }
+#endif
     m_thread.join();
+#if defined(PLATFORM_LINUX)
+    if (m_inotify != -1) {
+        close(m_inotify);
+    }
+    if (m_wakeup != -1) {
+        close(m_wakeup);
+    }
+#endif
+}
+
+int
+Watcher::aux_init_inotify()
+{
+#if defined(PLATFORM_LINUX)
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd == -1) {
+        Log::w("inotify unavailable, falling back to polling: {}", std::strerror(errno));
+        return -1;
+    }
+    m_wakeup = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_wakeup == -1) {
+        Log::w("eventfd unavailable, falling back to polling: {}", std::strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+#else
+    return -1;
+#endif
+}
+
+void
+Watcher::aux_watch_directory(const FS::path& directory)
+{
+#if defined(PLATFORM_LINUX)
+    if (m_inotify == -1) {
+        return;
+    }
+    // inotify returns the same descriptor for the same directory, so adding again is harmless.
+    int wd = inotify_add_watch(m_inotify, directory.c_str(), IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+    if (wd == -1) {
+        Log::e("Failed to watch directory {}: {}", directory, std::strerror(errno));
+        return;
+    }
+    m_directories[wd] = directory;
+#endif
+}
+
+void
+Watcher::aux_watch_tree(const FS::path& directory, FS::FileList* found)
+{
+#if defined(PLATFORM_LINUX)
+    aux_watch_directory(directory);
+    DIR* dir = opendir(directory.c_str());
+    if (!dir) {
+        Log::e("Failed to open directory {}: {}", directory, std::strerror(errno));
+        return;
+    }
+    while (auto* entry = readdir(dir)) {
+        if (!std::strcmp(entry->d_name, ".") || !std::strcmp(entry->d_name, "..")) {
+            continue;
+        }
+        auto&& path = directory / entry->d_name;
+        bool is_directory = entry->d_type == DT_DIR;
+        if (entry->d_type == DT_UNKNOWN) { // not every file system fills in d_type
+            std::error_code ec;
+            is_directory = FS::details::is_directory(FS::details::symlink_status(path, ec));
+        }
+        if (is_directory) {
+            aux_watch_tree(path, found);
+        } else if (found) {
+            found->push_back(std::move(path));
+        }
+    }
+    closedir(dir);
+#endif
+}
+
+bool
+Watcher::aux_match(const Tree& tree, const FS::path& path)
+{
+    auto&& root = tree.root.string();
+    auto&& str = path.string();
+    return is_inside(root, str) && FS::glob_match(tree.pattern, str.substr(root.size() + 1));
+}
+
+void
+Watcher::aux_settled(const FS::path& path)
+{
+    for (auto&& tag : m_tags) {
+        auto it = m_watching_files.find(std::make_pair(path, tag));
+        if (it != m_watching_files.end()) {
+            aux_check(it->second);
+        }
+    }
+    for (auto&& tree : m_trees) {
+        if (!m_watching_files.count(std::make_pair(path, tree.tag)) && aux_match(tree, path)) {
+            aux_import(path, tree.tag);
+        }
+    }
+}
+
+void
+Watcher::aux_import(const FS::path& path, const std::string& tag)
+{
+    std::error_code ec;
+    if (!OpenGL::suffix_shader_type(path.extension()) || !FS::details::is_regular_file(path, ec)) {
+        return;
+    }
+    ImportedFile file(path.string(), FileType::Shader, tag);
+    if (file.path().empty()) {
+        return; // vanished in the meantime
+    }
+    Log::i("Found {}[{}]", file.path(), tag);
+    m_tags.insert(tag);
+    m_watching_files.emplace(std::make_pair(file.path(), tag), file);
+    aux_push(file);
+}
+
+void
+Watcher::aux_push(const ImportedFile& file)
+{
+    aux_flush();
+    if (!m_overflow.empty() || !m_updated.push(file)) {
+        m_overflow.push_back(file);
+    }
+}
+
+void
+Watcher::aux_flush()
+{
+    while (!m_overflow.empty() && m_updated.push(m_overflow.front())) {
+        m_overflow.pop_front();
+    }
+}
+
+void
+Watcher::aux_check(const ImportedFile& file)
+{
+    if (file.check_update()) {
+        aux_push(file);
+    }
+}
+
+void
+Watcher::aux_loop_inotify()
+{
+#if defined(PLATFORM_LINUX)
+    // buffer large enough for a burst of events; aligned as inotify_event requires.
+    alignas(inotify_event) char buffer[16 * (sizeof(inotify_event) + NAME_MAX + 1)];
+    pollfd fds[2] = {{m_inotify, POLLIN, 0},
+                     {m_wakeup,  POLLIN, 0}};
+    // files with recent events -> time point they are considered settled
+    std::unordered_map<FS::path, Clock::time_point> pending;
+    const auto settle = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<float, std::milli>(options.watch.settle));
+    while (m_watching) {
+        aux_flush();
+        // retry handing over overflown files every so often
+        int timeout = m_overflow.empty() ? -1 : static_cast<int>(PollInterval);
+        if (!pending.empty()) {
+            auto earliest = Clock::time_point::max();
+            for (auto&&[_, deadline] : pending) {
+                earliest = std::min(earliest, deadline);
+            }
+            auto&& remaining = std::chrono::ceil<std::chrono::milliseconds>(earliest - Clock::now());
+            auto&& settling = static_cast<int>(std::max<std::chrono::milliseconds::rep>(0, remaining.count()));
+            timeout = timeout == -1 ? settling : std::min(timeout, settling);
+        }
+        if (poll(fds, 2, timeout) == -1) {
+            if (errno != EINTR) {
+                Log::e("Failed to poll inotify: {}", std::strerror(errno));
+                break;
+            }
+            continue;
+        }
+        if (fds[1].revents & POLLIN) {
+            break; // woken up by destructor
+        }
+        std::lock_guard guard(mutex_watching_files);
+        ssize_t length;
+        while ((length = read(m_inotify, buffer, sizeof(buffer))) > 0) {
+            auto&& deadline = Clock::now() + settle;
+            for (char* ptr = buffer; ptr < buffer + length;) {
+                auto* event = reinterpret_cast<const inotify_event*>(ptr);
+                ptr += sizeof(inotify_event) + event->len;
+                if (event->mask & IN_IGNORED) {
+                    m_directories.erase(event->wd);
+                    continue;
+                }
+                auto it = m_directories.find(event->wd);
+                if (it == m_directories.end() || event->len == 0) {
+                    continue;
+                }
+                auto&& path = it->second / event->name;
+                if ((event->mask & IN_ISDIR) && (event->mask & (IN_CREATE | IN_MOVED_TO))) {
+                    // a new directory inside a tree; whatever got into it before being watched is pending too
+                    bool in_tree = std::any_of(m_trees.begin(), m_trees.end(), [&](const Tree& tree)
+                    { return is_inside(tree.root.string(), path.string()); });
+                    if (in_tree) {
+                        FS::FileList found;
+                        aux_watch_tree(path, &found);
+                        for (auto&& file : found) {
+                            pending[file] = deadline;
+                        }
+                    }
+                    continue;
+                }
+                pending[path] = deadline;
+            }
+        }
+        auto&& now = Clock::now();
+        for (auto it = pending.begin(); it != pending.end();) {
+            if (it->second > now) {
+                ++it;
+                continue;
+            }
+            aux_settled(it->first);
+            it = pending.erase(it);
+        }
+    }
+#endif
+}
+
+void
+Watcher::aux_loop_polling()
+{
+    while (m_watching) {
+        {
+            std::lock_guard guard(mutex_watching_files);
+            aux_flush();
+            for (auto&&[_, file] : m_watching_files) {
+                aux_check(file);
+            }
+            for (auto&& tree : m_trees) {
+                std::error_code ec;
+                for (FS::details::recursive_directory_iterator it(tree.root, ec), end; !ec && it != end;
+                     it.increment(ec)) {
+                    auto&& path = it->path();
+                    if (tree.known.insert(path).second && aux_match(tree, path)) {
+                        aux_import(path, tree.tag);
+                    }
+                }
+            }
+        }
+        sleep_for_ms(PollInterval);
+    }
 }
 
 void
@@ -65,6 +332,9 @@ Watcher::watch(const FS::path& path, FileType type, const std::string& tag)
     auto&&[it, result] = m_watching_files.emplace(std::make_pair(path, tag), ImportedFile(path, type, tag));
     if (!result) {
         Log::w("Already watching {}", path);
+    } else {
+        m_tags.insert(tag);
+        aux_watch_directory(it->second.path().parent_path());
     }
 }
 
@@ -76,7 +346,44 @@ Watcher::unwatch(const FS::path& path, const std::string& tag)
         return;
     }
     std::lock_guard guard(mutex_watching_files);
-    m_watching_files.erase(std::make_pair(path, tag));
+    if (m_watching_files.erase(std::make_pair(path, tag))) {
+        aux_forget_tag(tag);
+    }
+}
+
+void
+Watcher::aux_forget_tag(const std::string& tag)
+{
+    // files imported from trees carry their tag, and trees are matched without it
+    bool used = std::any_of(m_watching_files.begin(), m_watching_files.end(), [&tag](auto&& entry)
+    { return entry.first.second == tag; });
+    if (!used) {
+        m_tags.erase(tag);
+    }
+}
+
+void
+Watcher::watch_tree(const std::string& glob, const std::string& tag)
+{
+    auto&&[root, pattern] = FS::glob_split(glob);
+    auto&& canonical = FS::canonical(root.string());
+    if (!canonical) {
+        Log::e("Can not watch {}: {}", glob, canonical.error());
+        return;
+    }
+    std::lock_guard guard(mutex_watching_files);
+    Tree tree{*canonical, pattern, tag, {}};
+    if (m_inotify != -1) {
+        aux_watch_tree(tree.root, nullptr);
+    } else {
+        // files already there are not new
+        std::error_code ec;
+        for (FS::details::recursive_directory_iterator it(tree.root, ec), end; !ec && it != end; it.increment(ec)) {
+            tree.known.insert(it->path());
+        }
+    }
+    Log::i("Watching {} for {}[{}]", tree.root, tree.pattern, tag);
+    m_trees.push_back(std::move(tree));
 }
 
 expected<ImportedFile, std::string>
@@ -115,6 +422,9 @@ ImportedFile::ImportedFile(const std::string& path, FileType type, std::string t
     } else {
         Log::e("{}", ex.error());
     }
+    if (auto&& ex = fetch()) {
+        m_hash = hash64(*ex);
+    }
 }
 
 expected<std::string, std::string>
@@ -136,10 +446,21 @@ bool
 ImportedFile::check_update() const
 {
     if (auto&& ex = FS::last_write_time(m_path)) {
-        if (*ex > m_last_modified) {
-            m_last_modified = *ex;
-            return true;
+        if (*ex == m_last_modified) {
+            return false;
+        }
+        m_last_modified = *ex;
+        auto&& content = fetch();
+        if (!content) {
+            Log::e("{}", content.error());
+            return false;
+        }
+        auto hash = hash64(*content);
+        if (hash == m_hash) {
+            return false;
         }
+        m_hash = hash;
+        return true;
     } else {
         Log::e("{}", ex.error());
     }
@@ -4,8 +4,10 @@
  */
 #include <Console.hpp>
 #include <Sandbox.hpp>
+#include <Validator.hpp>
 #include <Window.hpp>
 #include <csignal>
+#include <iostream>
 
 // TODO support simple texture
 // TODO load texture from .obj
@@ -59,21 +61,28 @@ main(int argc, char** argv)
         print_usage(argv[0]);
         std::exit(EXIT_SUCCESS);
     }
+    if (!options.validate.directory.empty()) {
+        std::exit(validate_shaders(options.validate.directory, options.validate.jobs, std::cout));
+    }
     // prepare everything
     OpenGL::Initialize();
     Watcher watcher(options.input_files);
+    for (auto&& glob : options.watch.trees) {
+        watcher.watch_tree(glob, "user");
+    }
     sandbox = std::make_unique<Sandbox>(watcher);
     declare_commands();
     console->execute_all(options.initial_commands);
     // main loop
+    ImportedFile updated; // reused to recycle its buffers
     while (1000 * glfwGetTime() < options.application.TTL && options.flags.running && !main_window->closed()) {
         main_window->next_frame();
         console->execute_all();
         console->flush();
-        auto&& updated = watcher.updated();
-        for (auto&& file : updated) {
-            sandbox->import(file);
+        while (watcher.pop_updated(updated)) {
+            sandbox->import(updated);
         }
+        sandbox->update();
         sandbox->render_background();
         sandbox->render();
         sandbox->render_postprocess();
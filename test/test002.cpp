@@ -0,0 +1,425 @@
+#include <IncludeGraph.hpp>
+#include <Preprocessor.hpp>
+#include <Utility/Hash.hpp>
+#include <Utility/LRUCache.hpp>
+#include <Utility/SPSCQueue.hpp>
+#include <OpenGL/Introspection/ResourceIndex.hpp>
+#include <OpenGL/Introspection/InterfaceData.hpp>
+#include <OpenGL/Introspection/InterfaceDiff.hpp>
+#include <OpenGL/Introspection/SubroutineSelection.hpp>
+#include <OpenGL/Introspection/UniformHandle.hpp>
+#include <OpenGL/Introspection/UniformShadow.hpp>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+// the logging macro of Utility/Debug.hpp, pulled in by introspection headers, would shadow Catch's
+#undef INFO
+#include <catch2/catch.hpp>
+
+
+TEST_CASE("Include graph tracks reverse edges incrementally")
+{
+    IncludeGraph graph;
+    const FS::path a = "/a.frag", b = "/b.frag", noise = "/noise.glsl", util = "/util.glsl";
+    auto changes = graph.update(a, {noise}, true);
+    REQUIRE(changes.added.size() == 2);
+    graph.update(b, {util}, true);
+    graph.update(noise, {util});
+    GIVEN("A file included by one program only") {
+        auto&& dependents = graph.dependents(noise);
+        REQUIRE(dependents.count(a) == 1);
+        REQUIRE(dependents.count(b) == 0);
+    }
+    GIVEN("A file included by both programs, directly and indirectly") {
+        auto&& dependents = graph.dependents(util);
+        REQUIRE(dependents.count(a) == 1);
+        REQUIRE(dependents.count(b) == 1);
+        REQUIRE(graph.closure(a).count(util) == 1);
+    }
+    GIVEN("An include line removed") {
+        changes = graph.update(a, {});
+        REQUIRE(changes.removed == FS::FileList{noise});
+        REQUIRE(graph.contains(util)); // still included by b
+        REQUIRE(graph.dependents(util).count(a) == 0);
+        changes = graph.remove_root(b);
+        REQUIRE(changes.removed.size() == 2);
+        REQUIRE(!graph.contains(util));
+        REQUIRE(graph.contains(a));
+    }
+    GIVEN("Two included files including each other") {
+        const FS::path ping = "/ping.glsl", pong = "/pong.glsl";
+        graph.update(a, {noise, ping});
+        graph.update(ping, {pong});
+        graph.update(pong, {ping});
+        REQUIRE(graph.dependents(pong).count(a) == 1);
+        changes = graph.update(a, {noise});
+        REQUIRE(changes.removed.size() == 2);
+        REQUIRE(!graph.contains(ping));
+        REQUIRE(!graph.contains(pong));
+        REQUIRE(graph.contains(noise));
+    }
+    GIVEN("Includes scanned as the preprocessor recognizes them") {
+        auto&& directory = FS::details::temp_directory_path() / "include_graph_test";
+        FS::details::create_directories(directory);
+        std::ofstream(directory / "lib.glsl") << "float lib() { return 1.0; }\n";
+        std::ofstream(directory / "old.glsl") << "float old() { return 0.0; }\n";
+        auto&& main = directory / "main.frag";
+        std::ofstream(main) << "#version 430\n#include <lib.glsl>\n/*\n#include \"old.glsl\"\n*/\nvoid main() {}\n";
+        SourceFiles files;
+        auto&& includes = scan_includes(main, files);
+        REQUIRE(includes);
+        REQUIRE(includes->size() == 1);
+        REQUIRE(includes->front().filename() == "lib.glsl");
+        changes = graph.update(main, *includes, true);
+        REQUIRE(graph.dependents(includes->front()).count(main) == 1);
+        REQUIRE(!graph.contains(directory / "old.glsl"));
+    }
+}
+
+TEST_CASE("Glob pattern matching")
+{
+    GIVEN("A recursive pattern") {
+        auto&&[root, pattern] = FS::glob_split("shaders/**/*.frag");
+        REQUIRE(root == "shaders");
+        REQUIRE(FS::glob_match(pattern, "a.frag"));
+        REQUIRE(FS::glob_match(pattern, "lib/noise/a.frag"));
+        REQUIRE(!FS::glob_match(pattern, "lib/a.vert"));
+        REQUIRE(!FS::glob_match(pattern, "a.frag/b.vert"));
+    }
+    GIVEN("Wildcards within a component") {
+        auto&&[root, pattern] = FS::glob_split("*/light?.glsl");
+        REQUIRE(root == ".");
+        REQUIRE(FS::glob_match(pattern, "lib/light1.glsl"));
+        REQUIRE(!FS::glob_match(pattern, "light1.glsl"));
+        REQUIRE(!FS::glob_match(pattern, "lib/sub/light1.glsl"));
+    }
+}
+
+TEST_CASE("XXH64 matches reference vectors")
+{
+    REQUIRE(hash64("") == 0xef46db3751d8e999ull);
+    GIVEN("Inputs shorter than a stripe of 32 bytes") {
+        REQUIRE(hash64("a") == 0xd24ec4f1a98c6e5bull);
+        REQUIRE(hash64("abc") == 0x44bc2cf5ad770999ull);
+    }
+    GIVEN("An input longer than a stripe") {
+        REQUIRE(hash64("Nobody inspects the spammish repetition") == 0xfbcea83c8a378bf1ull);
+    }
+}
+
+TEST_CASE("LRU cache bounds total cost")
+{
+    LRUCache<int, std::string> cache(10);
+    cache.insert(1, "one", 4);
+    cache.insert(2, "two", 4);
+    REQUIRE(cache.cost() == 8);
+    REQUIRE(cache.find(1)); // 2 is now the least recently used
+    cache.insert(3, "three", 4);
+    REQUIRE(cache.size() == 2);
+    REQUIRE(cache.cost() == 8);
+    REQUIRE_FALSE(cache.find(2));
+    REQUIRE(*cache.find(1) == "one");
+    GIVEN("An entry replaced with a different cost") {
+        cache.insert(1, "uno", 1);
+        REQUIRE(cache.cost() == 5);
+        REQUIRE(*cache.find(1) == "uno");
+    }
+    GIVEN("An entry costing more than capacity") {
+        cache.insert(4, "four", 20);
+        REQUIRE(cache.size() == 1);
+        REQUIRE(cache.cost() == 20);
+        REQUIRE(*cache.find(4) == "four");
+    }
+    GIVEN("Shrinking capacity") {
+        cache.set_capacity(4);
+        REQUIRE(cache.size() == 1);
+        REQUIRE(cache.find(1));
+        cache.erase(1);
+        REQUIRE(cache.cost() == 0);
+    }
+}
+
+TEST_CASE("SPSC queue wraps around and refuses to overflow")
+{
+    SPSCQueue<std::string, 4> queue;
+    std::string value;
+    REQUIRE(queue.empty());
+    REQUIRE_FALSE(queue.pop(value));
+    for (auto&& s : {"a", "b", "c", "d"}) {
+        REQUIRE(queue.push(s));
+    }
+    REQUIRE_FALSE(queue.push("e")); // full
+    REQUIRE(queue.pop(value));
+    REQUIRE(value == "a");
+    REQUIRE(queue.pop(value));
+    REQUIRE(value == "b");
+    GIVEN("Slots freed reused from the start of the ring") {
+        REQUIRE(queue.push("e"));
+        REQUIRE(queue.push("f"));
+        REQUIRE_FALSE(queue.push("g"));
+        for (auto&& s : {"c", "d", "e", "f"}) {
+            REQUIRE(queue.pop(value));
+            REQUIRE(value == s);
+        }
+        REQUIRE(queue.empty());
+        REQUIRE_FALSE(queue.pop(value));
+        REQUIRE(value == "f"); // left untouched
+    }
+    GIVEN("A producer thread retrying pushes refused while full") {
+        std::thread producer([&queue]()
+        {
+            for (int i = 0; i < 10000; ++i) {
+                while (!queue.push(std::to_string(i))) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+        std::vector<std::string> received, expected{"c", "d"};
+        for (int i = 0; i < 10000; ++i) {
+            expected.push_back(std::to_string(i));
+        }
+        while (received.size() < expected.size()) {
+            if (queue.pop(value)) {
+                received.push_back(value);
+            }
+        }
+        producer.join();
+        REQUIRE(received == expected);
+        REQUIRE(queue.empty());
+    }
+}
+
+TEST_CASE("Resource index finds names by hash")
+{
+    static_assert(hash_name("u_time") == OpenGL::ResourceKey("u_time").hash, "hashed at compile time");
+    struct Named {
+        std::string name;
+    };
+    std::vector<Named> resources;
+    for (int i = 0; i < 100; ++i) {
+        resources.push_back({"u_" + std::to_string(i)});
+    }
+    OpenGL::details::ResourceIndex index;
+    using OpenGL::details::ResourceIndex;
+    REQUIRE(index.find(resources, "u_1") == ResourceIndex::npos); // not built yet
+    index.build(resources);
+    for (std::size_t i = 0; i < resources.size(); ++i) {
+        REQUIRE(index.find(resources, resources[i].name) == i);
+    }
+    constexpr OpenGL::ResourceKey key = "u_42";
+    REQUIRE(index.find(resources, key) == 42);
+    REQUIRE(index.find(resources, std::string_view("u_42x", 4)) == 42);
+    REQUIRE(index.find(resources, "u_100") == ResourceIndex::npos);
+    REQUIRE(index.find(resources, "") == ResourceIndex::npos);
+}
+
+TEST_CASE("Uniform handles check types against declarations")
+{
+    using OpenGL::details::UniformTraits;
+    using OpenGL::details::uniform_accepts;
+    static_assert(UniformTraits<GLfloat>::type == GL_FLOAT);
+    static_assert(UniformTraits<glm::ivec4>::type == GL_INT_VEC4);
+    static_assert(UniformTraits<glm::uvec2>::type == GL_UNSIGNED_INT_VEC2);
+    static_assert(UniformTraits<glm::dvec3>::type == GL_DOUBLE_VEC3);
+    static_assert(UniformTraits<glm::mat3>::type == GL_FLOAT_MAT3);
+    static_assert(UniformTraits<glm::mat2x4>::type == GL_FLOAT_MAT2x4);
+    static_assert(UniformTraits<glm::dmat4x3>::type == GL_DOUBLE_MAT4x3);
+    static_assert(UniformTraits<std::array<glm::vec3, 8>>::type == GL_FLOAT_VEC3);
+    static_assert(UniformTraits<std::array<glm::vec3, 8>>::count == 8);
+    REQUIRE(uniform_accepts(GL_FLOAT_VEC3, GL_FLOAT_VEC3));
+    REQUIRE_FALSE(uniform_accepts(GL_FLOAT_VEC3, GL_FLOAT_VEC4));
+    REQUIRE_FALSE(uniform_accepts(GL_INT_VEC2, GL_FLOAT_VEC2));
+    REQUIRE_FALSE(uniform_accepts(GL_FLOAT, GL_INT));
+    REQUIRE(uniform_accepts(GL_BOOL_VEC2, GL_INT_VEC2));
+    REQUIRE(uniform_accepts(GL_BOOL, GL_FLOAT));
+    REQUIRE_FALSE(uniform_accepts(GL_BOOL_VEC3, GL_INT_VEC2));
+    REQUIRE(uniform_accepts(GL_SAMPLER_2D, GL_INT));
+    REQUIRE_FALSE(uniform_accepts(GL_SAMPLER_2D, GL_UNSIGNED_INT));
+}
+
+TEST_CASE("Interface data survives a snapshot")
+{
+    OpenGL::details::InterfaceData data;
+    data.n_resources = 2;
+    data.stride = 3;
+    data.max_name_length = 4;
+    data.values = {4, 1, 2, 3, 3, 4};
+    data.subroutine_name_lengths = {2};
+    data.names_size = 9;
+    data.names = std::make_unique<GLchar[]>(data.names_size);
+    std::memcpy(data.names.get(), "f\0abc\0de", data.names_size);
+    std::string snapshot;
+    data.write(snapshot);
+    data.write(snapshot);
+    std::string_view in = snapshot;
+    OpenGL::details::InterfaceData first, second;
+    REQUIRE(first.read(in));
+    REQUIRE(second.read(in));
+    REQUIRE(in.empty());
+    REQUIRE(second.n_resources == 2);
+    REQUIRE(second.max_name_length == 4);
+    REQUIRE(second.values == data.values);
+    REQUIRE(second.row(1)[0] == 3);
+    REQUIRE(second.subroutine_name_lengths == data.subroutine_name_lengths);
+    REQUIRE(std::string_view(second.names.get() + 2, 3) == "abc");
+    in = std::string_view(snapshot).substr(0, snapshot.size() / 2 - 1);
+    REQUIRE_FALSE(first.read(in));
+}
+
+TEST_CASE("Shader storage blocks survive a snapshot")
+{
+    // layout(std430, binding = 3) buffer Lights { uint count; vec4 colors[]; };
+    OpenGL::details::InterfaceData variables;
+    variables.n_resources = 2;
+    variables.stride = 1 + static_cast<GLint>(OpenGL::BufferVariable::n_properties);
+    variables.max_name_length = 10;
+    variables.values = {6, GL_UNSIGNED_INT, 1, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 1, 0,
+                        10, GL_FLOAT_VEC4, 0, 16, 0, 16, 0, 0, 0, 16, 0, 0, 0, 0, 1, 0};
+    variables.names_size = 16;
+    variables.names = std::make_unique<GLchar[]>(variables.names_size);
+    std::memcpy(variables.names.get(), "count\0colors[0]", variables.names_size);
+    OpenGL::details::InterfaceData blocks;
+    blocks.n_resources = 1;
+    blocks.max_name_length = 7;
+    blocks.max_n_variables = 2;
+    blocks.stride = 1 + static_cast<GLint>(OpenGL::ShaderStorageBlock::n_properties) + blocks.max_n_variables;
+    blocks.values = {7, 3, 32, 2, 0, 0, 0, 0, 1, 0, 0, 1};
+    blocks.names_size = 7;
+    blocks.names = std::make_unique<GLchar[]>(blocks.names_size);
+    std::memcpy(blocks.names.get(), "Lights", blocks.names_size);
+    std::string snapshot;
+    variables.write(snapshot);
+    blocks.write(snapshot);
+    std::string_view in = snapshot;
+    OpenGL::details::InterfaceData restored_variables, restored_blocks;
+    REQUIRE(restored_variables.read(in));
+    REQUIRE(restored_blocks.read(in));
+    REQUIRE(in.empty());
+    REQUIRE(OpenGL::BufferVariableInterface::Consistent(restored_variables));
+    REQUIRE(OpenGL::ShaderStorageBlockInterface::Consistent(restored_blocks));
+    // as Introspector::Restore rebuilds them, members of blocks pointing into the buffer variables restored
+    OpenGL::BufferVariableInterface buffer_variables(0, std::move(restored_variables));
+    OpenGL::ShaderStorageBlockInterface storage_blocks(0, std::move(restored_blocks), buffer_variables.resources);
+    auto* block = storage_blocks.find("Lights");
+    REQUIRE(block);
+    REQUIRE(block->binding == 3);
+    REQUIRE(block->size == 32);
+    REQUIRE(block->variables.size() == 2);
+    REQUIRE(block->variables[0] == &buffer_variables.resources[0]);
+    REQUIRE(block->variables[1] == &buffer_variables.resources[1]);
+    auto* colors = block->find("colors[0]");
+    REQUIRE(colors == buffer_variables.find("colors[0]"));
+    REQUIRE(colors->offset == 16);
+    REQUIRE(colors->top_level_asize == 0); // unsized
+    REQUIRE(colors->top_level_astride == 16);
+    REQUIRE(block->find("count")->top_level_asize == 1);
+    REQUIRE(block->referenced[underlying_cast(OpenGL::ShaderStage::Fragment)]);
+}
+
+namespace {
+
+/// Input interface of vertex inputs named @p names, of @p types and at @p locations, as if introspected.
+OpenGL::ProgramInputInterface
+make_inputs(const std::vector<std::string>& names, const std::vector<GLint>& types, const std::vector<GLint>& locations)
+{
+    OpenGL::details::InterfaceData data;
+    data.n_resources = static_cast<GLint>(names.size());
+    data.stride = 1 + static_cast<GLint>(OpenGL::ProgramInput::n_properties);
+    std::string arena;
+    for (std::size_t i = 0; i < names.size(); ++i) {
+        std::vector<GLint> row(data.stride, 0);
+        row[0] = static_cast<GLint>(names[i].size() + 1);
+        row[1] = types[i];
+        row[2] = 1;
+        row[3] = locations[i];
+        data.values.insert(data.values.end(), row.begin(), row.end());
+        arena.append(names[i]).push_back('\0');
+    }
+    data.names_size = arena.size();
+    data.names = std::make_unique<GLchar[]>(data.names_size);
+    std::memcpy(data.names.get(), arena.data(), data.names_size);
+    return OpenGL::ProgramInputInterface(0, std::move(data));
+}
+
+} // namespace
+
+TEST_CASE("Interfaces diff by name, type and location")
+{
+    auto before = make_inputs({"a_pos", "a_normal", "a_uv", "a_tangent"},
+                              {GL_FLOAT_VEC3, GL_FLOAT_VEC3, GL_FLOAT_VEC2, GL_FLOAT_VEC3}, {0, 1, 2, 3});
+    auto after = make_inputs({"a_color", "a_uv", "a_normal", "a_pos"},
+                             {GL_FLOAT_VEC3, GL_FLOAT_VEC2, GL_FLOAT_VEC4, GL_FLOAT_VEC3}, {2, 3, 1, 0});
+    auto diff = OpenGL::diff(before, after);
+    REQUIRE(diff.added == std::vector<std::string>{"a_color"});
+    REQUIRE(diff.removed == std::vector<std::string>{"a_tangent"});
+    REQUIRE(diff.retyped == std::vector<std::string>{"a_normal"});
+    REQUIRE(diff.moved == std::vector<std::string>{"a_uv"});
+    REQUIRE(diff.matched == std::vector<std::pair<GLint, GLint>>{{0, 3}, {2, 1}});
+    REQUIRE(diff.summary() == "+1 -1 ~1 >1");
+    REQUIRE(OpenGL::diff(after, after).empty());
+
+    REQUIRE(OpenGL::signature(before) != OpenGL::signature(after));
+    auto same = make_inputs({"a_pos", "a_normal", "a_uv", "a_tangent"},
+                            {GL_FLOAT_VEC3, GL_FLOAT_VEC3, GL_FLOAT_VEC2, GL_FLOAT_VEC3}, {0, 1, 2, 3});
+    REQUIRE(OpenGL::signature(before) == OpenGL::signature(same));
+}
+
+TEST_CASE("Uniform shadow skips values uploaded already")
+{
+    auto&& uploads = OpenGL::details::UniformShadow::Uploads();
+    uploads = {};
+    OpenGL::details::UniformShadow shadow;
+    glm::vec3 v{1, 2, 3};
+    float t = 0.5f;
+    REQUIRE(shadow.update(5, &v, sizeof(v)));
+    REQUIRE_FALSE(shadow.update(5, &v, sizeof(v)));
+    REQUIRE(shadow.update(0, &t, sizeof(t)));
+    v.y = 4;
+    REQUIRE(shadow.update(5, &v, sizeof(v)));
+    // fewer elements of an array are a different value
+    REQUIRE(shadow.update(5, &v, sizeof(float)));
+    REQUIRE(uploads.issued == 4);
+    REQUIRE(uploads.skipped == 1);
+    GIVEN("A value carried over from a program reloaded, bypassing the shadow") {
+        REQUIRE_FALSE(shadow.update(0, &t, sizeof(t)));
+        shadow.forget(0);
+        // whatever the GL holds now, the value must be uploaded again
+        REQUIRE(shadow.update(0, &t, sizeof(t)));
+        REQUIRE_FALSE(shadow.update(5, &v, sizeof(float)));
+        shadow.forget(100); // never recorded
+        REQUIRE_FALSE(shadow.update(5, &v, sizeof(float)));
+    }
+    shadow.clear();
+    REQUIRE(shadow.update(0, &t, sizeof(t)));
+}
+
+TEST_CASE("Subroutine selection falls back to the first compatible subroutine")
+{
+    const std::vector<OpenGL::Resource> stage_subroutines{{0, "lambert"}, {1, "phong"}, {2, "toon"}};
+    // array size, location, number of compatible subroutines, then their indices
+    const GLint values[] = {1, 0, 2, 1, 2};
+    OpenGL::FragmentSubroutineUniform shade(0, 0, "shade", values, stage_subroutines);
+    OpenGL::SubroutineSelection selection;
+    REQUIRE(selection.subroutine(shade)->name == "phong");
+    auto version = selection.version();
+    selection.select("shade", "toon");
+    REQUIRE(selection.version() != version);
+    REQUIRE(selection.subroutine(shade)->name == "toon");
+    REQUIRE(selection.subroutine(shade)->index == 2);
+    GIVEN("A subroutine the uniform is not compatible with") {
+        selection.select("shade", "lambert");
+        REQUIRE(selection.subroutine(shade)->name == "phong");
+    }
+    GIVEN("The selection dropped") {
+        version = selection.version();
+        selection.deselect("shade");
+        REQUIRE(selection.version() != version);
+        REQUIRE(selection.selected().empty());
+        REQUIRE(selection.subroutine(shade)->name == "phong");
+        version = selection.version();
+        selection.deselect("shade");
+        REQUIRE(selection.version() == version);
+    }
+}
@@ -0,0 +1,88 @@
+#include <catch2/catch.hpp>
+#include <Preprocessor.hpp>
+#include <fstream>
+
+
+namespace {
+
+FS::path
+write(const FS::path& directory, const std::string& name, const std::string& content)
+{
+    auto&& path = directory / name;
+    std::ofstream(path) << content;
+    return path;
+}
+
+}
+
+TEST_CASE("Preprocessor expands includes with line remapping")
+{
+    auto&& directory = FS::details::temp_directory_path() / "preprocessor_test";
+    FS::details::create_directories(directory);
+    write(directory, "util.glsl", "float util() { return 1.0; }\n");
+    write(directory, "noise.glsl", "#include \"util.glsl\"\nfloat noise() { return util(); }\n");
+    Preprocessor preprocessor;
+    preprocessor.define("BACKGROUND");
+    preprocessor.define("SCALE=2");
+    GIVEN("A shader including a file twice, directly and indirectly") {
+        auto&& main = write(directory, "main.frag",
+                            "// header\n#version 330\n#include \"noise.glsl\"\n"
+                            "/*\n#include \"missing.glsl\"\n*/\n  #  include \"util.glsl\"\nvoid main() {}");
+        auto&& result = preprocessor.process(main);
+        REQUIRE(result);
+        REQUIRE(result->files.size() == 3);
+        REQUIRE(result->files[1].filename() == "noise.glsl");
+        REQUIRE(result->source == "// header\n#version 330\n#define BACKGROUND\n#define SCALE 2\n"
+                                  "float util() { return 1.0; }\nfloat noise() { return util(); }\n"
+                                  "/*\n#include \"missing.glsl\"\n*/\n\nvoid main() {}\n");
+        auto&& lines = result->lines;
+        REQUIRE(lines.locate(2).file == 0);
+        REQUIRE(lines.locate(2).line == 2);
+        REQUIRE(lines.locate(4).file == LineMap::Generated);
+        REQUIRE(lines.locate(5).file == 2);
+        REQUIRE(lines.locate(5).line == 1);
+        REQUIRE(lines.locate(6).file == 1);
+        REQUIRE(lines.locate(6).line == 2);
+        REQUIRE(lines.locate(11).file == 0);
+        REQUIRE(lines.locate(11).line == 8);
+        REQUIRE(lines.rewrite("0(6) : error C0000: syntax error\nERROR: 0:11: 'x' : undeclared\n0:5(3): error: bad\n",
+                              {"main.frag", "noise.glsl", "util.glsl"}) ==
+                "noise.glsl:2 : error C0000: syntax error\nERROR: main.frag:8: 'x' : undeclared\n"
+                "util.glsl:1(3): error: bad\n");
+    }
+    GIVEN("A shader without '#version'") {
+        auto&& main = write(directory, "noversion.frag", "#include \"util.glsl\"\nvoid main() {}\n");
+        auto&& result = preprocessor.process(main);
+        REQUIRE(result);
+        REQUIRE(result->lines.locate(2).file == LineMap::Generated);
+        REQUIRE(result->lines.locate(3).file == 1);
+        REQUIRE(result->lines.locate(4).file == 0);
+        REQUIRE(result->lines.locate(4).line == 2);
+    }
+    GIVEN("Cyclic includes") {
+        write(directory, "a.glsl", "#include \"b.glsl\"\n");
+        write(directory, "b.glsl", "#pragma include \"a.glsl\"\n");
+        auto&& main = write(directory, "cycle.frag", "#version 330\n#include \"a.glsl\"\n");
+        auto&& result = preprocessor.process(main);
+        REQUIRE(!result);
+        REQUIRE(result.error().find("Cyclic") != std::string::npos);
+    }
+    GIVEN("An unresolvable include") {
+        auto&& main = write(directory, "missing.frag", "#version 330\n#include \"missing.glsl\"\n");
+        REQUIRE(!preprocessor.process(main));
+    }
+    GIVEN("Files read through a cache") {
+        SourceFiles files;
+        Preprocessor cached(files);
+        auto&& main = write(directory, "cached.frag", "#version 330\n#include \"util.glsl\"\n");
+        auto&& first = cached.process(main);
+        REQUIRE(first);
+        auto hash = (*files.get(first->files[1]))->hash;
+        write(directory, "util.glsl", "float util() { return 2.0; }\n");
+        REQUIRE(cached.process(main)->source == first->source);
+        files.invalidate(first->files[1]);
+        REQUIRE(cached.process(main)->source != first->source);
+        REQUIRE((*files.get(first->files[1]))->hash != hash);
+    }
+    FS::details::remove_all(directory);
+}